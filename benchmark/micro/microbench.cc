@@ -0,0 +1,727 @@
+/**
+ * Clever programming language
+ * Copyright (c) Clever Team
+ *
+ * This file is distributed under the MIT license. See LICENSE for details.
+ */
+
+/**
+ * Times the runtime primitives in isolation, without the parser or the VM
+ * in the way: value copies, environment activation, string interning,
+ * reference counting and the array and map containers. The parser and the
+ * compiler are timed on their own as well, on a large generated script.
+ *
+ * Every benchmark is calibrated to run for the given time per sample, and
+ * the median and the best time per operation of its samples are reported,
+ * one benchmark per line and always in the same order, so that the output
+ * of two builds can be compared with -b.
+ *
+ * Usage: microbench [options] [filter ...]
+ *
+ *   -s <samples>   samples of each benchmark (default: 5)
+ *   -t <ms>        time of each sample (default: 20)
+ *   -j <threads>   threads of the multi-threaded benchmarks (default: 4)
+ *   -b <file>      output of a previous run to compare with
+ *   -l             lists the benchmarks
+ *
+ * Only the benchmarks with a name starting with one of the filters are run.
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "core/program.h"
+#include "core/environment.h"
+#include "core/cstring.h"
+#include "core/cthread.h"
+#include "core/value.h"
+#include "core/native_types.h"
+#include "modules/std/core/array.h"
+#include "modules/std/core/map.h"
+
+using namespace clever;
+
+typedef unsigned long long nsecs_t;
+
+static nsecs_t now()
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return nsecs_t(ts.tv_sec) * 1000000000ULL + ts.tv_nsec;
+}
+
+/// Measures the timed part of a benchmark, leaving out its setup
+class Timer {
+public:
+	Timer()
+		: m_start(0), m_elapsed(0) {}
+
+	void start() { m_start = now(); }
+	void stop() { m_elapsed += now() - m_start; }
+
+	nsecs_t elapsed() const { return m_elapsed; }
+private:
+	nsecs_t m_start;
+	nsecs_t m_elapsed;
+};
+
+// Runs `n' operations of a benchmark, timing them with `timer'
+typedef void (*BenchFunc)(Timer& timer, size_t n);
+
+struct Benchmark {
+	const char* name;
+	BenchFunc func;
+};
+
+// Keeps the compiler from dropping the benchmarked work
+static volatile size_t g_sink;
+
+static size_t g_threads = 4;
+
+// Value copies
+// ---------------------------------------------------------------------------
+
+static void copy_value(Timer& timer, size_t n, const Value* src, bool deep)
+{
+	Value dst;
+
+	timer.start();
+	if (deep) {
+		for (size_t i = 0; i < n; ++i) {
+			dst.deepCopy(src);
+		}
+	} else {
+		for (size_t i = 0; i < n; ++i) {
+			dst.copy(src);
+		}
+	}
+	timer.stop();
+
+	g_sink += dst.isNull();
+}
+
+static Value* new_array(size_t size)
+{
+	ArrayObject* arr = new ArrayObject;
+	Value* value = new Value;
+
+	for (size_t i = 0; i < size; ++i) {
+		Value elem(static_cast<long>(i));
+
+		arr->pushValue(&elem);
+	}
+	value->setObj(CLEVER_ARRAY_TYPE, arr);
+	return value;
+}
+
+static void value_copy_int(Timer& timer, size_t n)
+{
+	Value src(42L);
+
+	copy_value(timer, n, &src, false);
+}
+
+static void value_copy_str(Timer& timer, size_t n)
+{
+	Value src(CSTRING("microbench"));
+
+	copy_value(timer, n, &src, false);
+}
+
+static void value_deepcopy_int(Timer& timer, size_t n)
+{
+	Value src(42L);
+
+	copy_value(timer, n, &src, true);
+}
+
+static void value_deepcopy_str(Timer& timer, size_t n)
+{
+	Value src(CSTRING("microbench"));
+
+	copy_value(timer, n, &src, true);
+}
+
+static void value_deepcopy_array(Timer& timer, size_t n)
+{
+	Value* src = new_array(16);
+
+	copy_value(timer, n, src, true);
+
+	src->delRef();
+}
+
+static void value_clone(Timer& timer, size_t n)
+{
+	Value src(42L);
+
+	timer.start();
+	for (size_t i = 0; i < n; ++i) {
+		src.clone()->delRef();
+	}
+	timer.stop();
+}
+
+// Environments
+// ---------------------------------------------------------------------------
+
+static void env_activate(Timer& timer, size_t n, size_t size)
+{
+	Environment* env = new Environment(NULL, false);
+
+	for (size_t i = 0; i < size; ++i) {
+		env->pushValue(new Value(long(i)));
+	}
+
+	timer.start();
+	for (size_t i = 0; i < n; ++i) {
+		env->activate()->delRef();
+	}
+	timer.stop();
+
+	env->delRef();
+}
+
+static void env_activate_0(Timer& timer, size_t n)
+{
+	env_activate(timer, n, 0);
+}
+
+static void env_activate_4(Timer& timer, size_t n)
+{
+	env_activate(timer, n, 4);
+}
+
+static void env_activate_16(Timer& timer, size_t n)
+{
+	env_activate(timer, n, 16);
+}
+
+// String interning
+// ---------------------------------------------------------------------------
+
+static void intern_hit(Timer& timer, size_t n)
+{
+	const std::string str("microbench");
+
+	CSTRING(str);
+
+	timer.start();
+	for (size_t i = 0; i < n; ++i) {
+		g_sink += CSTRING(str)->size();
+	}
+	timer.stop();
+}
+
+static void intern_miss(Timer& timer, size_t n)
+{
+	static size_t serial = 0;
+	std::vector<std::string> strs(n);
+
+	// Never interned before, even across the samples
+	for (size_t i = 0; i < n; ++i) {
+		std::ostringstream str;
+
+		str << "microbench." << serial++;
+		strs[i] = str.str();
+	}
+
+	timer.start();
+	for (size_t i = 0; i < n; ++i) {
+		g_sink += CSTRING(strs[i])->size();
+	}
+	timer.stop();
+}
+
+// Reference counting
+// ---------------------------------------------------------------------------
+
+static void refcount(Timer& timer, size_t n)
+{
+	Value* value = new Value(42L);
+
+	timer.start();
+	for (size_t i = 0; i < n; ++i) {
+		value->addRef();
+		value->delRef();
+	}
+	timer.stop();
+
+	value->delRef();
+}
+
+#ifdef CLEVER_THREADS
+struct RefCountTask {
+	RefCounted* obj;
+	size_t n;
+};
+
+static void* refcount_task(void* arg)
+{
+	RefCountTask* task = static_cast<RefCountTask*>(arg);
+
+	for (size_t i = 0; i < task->n; ++i) {
+		task->obj->addRef();
+		task->obj->delRef();
+	}
+	return NULL;
+}
+
+// Each thread does `n' operations, all of them on the same object when
+// `shared', which is the case of values passed between threads
+static void refcount_threads(Timer& timer, size_t n, bool shared)
+{
+	std::vector<Value*> values(g_threads);
+	std::vector<RefCountTask> tasks(g_threads);
+	std::vector<CThread*> threads(g_threads);
+
+	for (size_t i = 0; i < g_threads; ++i) {
+		values[i] = shared && i ? values[0] : new Value(42L);
+		tasks[i].obj = values[i];
+		tasks[i].n = n;
+		threads[i] = new CThread;
+	}
+
+	timer.start();
+	for (size_t i = 0; i < g_threads; ++i) {
+		threads[i]->create(refcount_task, &tasks[i]);
+	}
+	for (size_t i = 0; i < g_threads; ++i) {
+		threads[i]->wait();
+	}
+	timer.stop();
+
+	for (size_t i = 0; i < g_threads; ++i) {
+		delete threads[i];
+
+		if (!shared || i == 0) {
+			values[i]->delRef();
+		}
+	}
+}
+
+static void refcount_shared(Timer& timer, size_t n)
+{
+	refcount_threads(timer, n, true);
+}
+
+static void refcount_private(Timer& timer, size_t n)
+{
+	refcount_threads(timer, n, false);
+}
+#endif
+
+// Containers
+// ---------------------------------------------------------------------------
+
+static void array_push(Timer& timer, size_t n)
+{
+	ArrayObject* arr = new ArrayObject;
+	Value elem(42L);
+
+	timer.start();
+	for (size_t i = 0; i < n; ++i) {
+		arr->pushValue(&elem);
+	}
+	timer.stop();
+
+	timer.start();
+	arr->delRef();
+	timer.stop();
+}
+
+static std::vector<std::string> map_keys(size_t n)
+{
+	std::vector<std::string> keys(n);
+
+	for (size_t i = 0; i < n; ++i) {
+		std::ostringstream key;
+
+		key << "key" << i;
+		keys[i] = key.str();
+	}
+	return keys;
+}
+
+static void map_insert(Timer& timer, size_t n)
+{
+	std::vector<std::string> keys(map_keys(n));
+	MapObject* map = new MapObject;
+
+	timer.start();
+	for (size_t i = 0; i < n; ++i) {
+		map->insertValue(keys[i], new Value(long(i)));
+	}
+	timer.stop();
+
+	timer.start();
+	map->delRef();
+	timer.stop();
+}
+
+static void map_find(Timer& timer, size_t n)
+{
+	static const size_t size = 1024;
+	std::vector<std::string> keys(map_keys(size));
+	MapObject* map = new MapObject;
+	const MapObject* cmap = map;
+
+	for (size_t i = 0; i < size; ++i) {
+		map->insertValue(keys[i], new Value(long(i)));
+	}
+
+	timer.start();
+	for (size_t i = 0; i < n; ++i) {
+		g_sink += cmap->getData().find(keys[i % size]) != cmap->getData().end();
+	}
+	timer.stop();
+
+	map->delRef();
+}
+
+// Embedding
+// ---------------------------------------------------------------------------
+
+static Program g_program;
+
+static void context_call(Timer& timer, size_t n)
+{
+	Context ctx(&g_program);
+	const Function* func = g_program.getFunction("add");
+	ValueVector args;
+
+	args.push_back(new Value(1L));
+	args.push_back(new Value(2L));
+
+	ctx.run();
+
+	timer.start();
+	for (size_t i = 0; i < n; ++i) {
+		ctx.call(func, args)->delRef();
+	}
+	timer.stop();
+
+	std::for_each(args.begin(), args.end(), clever_delref);
+}
+
+static void context_reset(Timer& timer, size_t n)
+{
+	Context ctx(&g_program);
+
+	timer.start();
+	for (size_t i = 0; i < n; ++i) {
+		ctx.reset();
+		ctx.run();
+	}
+	timer.stop();
+}
+
+// Startup
+// ---------------------------------------------------------------------------
+
+// A whole run of a trivial script: registering the packages, importing,
+// compiling, running and shutting down, in an isolate of its own
+static void startup_trivial(Timer& timer, size_t n)
+{
+	timer.start();
+	for (size_t i = 0; i < n; ++i) {
+		Isolate isolate;
+		IsolateScope scope(&isolate);
+		Interpreter interp(g_clever_argc, g_clever_argv);
+
+		interp.loadStr("import std.io.*;\nvar x = 1;\n", false);
+		interp.execute(false);
+		interp.shutdown();
+	}
+	timer.stop();
+}
+
+// Parser
+// ---------------------------------------------------------------------------
+
+// A large generated script, like the config-as-code files whose parsing is
+// a noticeable part of the startup: about 700 KB of map and array literals
+// and of functions with some control flow
+static const std::string& large_source()
+{
+	static std::string source;
+
+	if (!source.empty()) {
+		return source;
+	}
+
+	std::ostringstream out;
+
+	for (size_t i = 0; i < 2500; ++i) {
+		out << "var cfg" << i << " = {\"name\": \"service" << i << "\", \"port\": "
+			<< 8000 + i << ", \"tags\": [\"web\", \"api\", " << i
+			<< "], \"enabled\": true};\n"
+			"function handler" << i << "(req, n) {\n"
+			"\tvar total = 0;\n"
+			"\tfor (var j = 0; j < n; ++j) {\n"
+			"\t\tif (j % 3 == 0) {\n"
+			"\t\t\ttotal += j * " << i << ";\n"
+			"\t\t} else {\n"
+			"\t\t\ttotal -= cfg" << i << "[\"port\"];\n"
+			"\t\t}\n"
+			"\t}\n"
+			"\treturn total + req;\n"
+			"}\n";
+	}
+	source = out.str();
+
+	return source;
+}
+
+// Compiles the large script, leaving out the registration of the packages
+static void compile_large(Timer& timer, size_t n, size_t flags)
+{
+	const std::string& source = large_source();
+
+	for (size_t i = 0; i < n; ++i) {
+		Isolate isolate;
+		IsolateScope scope(&isolate);
+		Interpreter interp(g_clever_argc, g_clever_argv);
+
+		interp.setCompilerFlags(flags);
+		interp.getCompiler().preload();
+
+		timer.start();
+		interp.loadStr(source, false);
+		interp.getCompiler().genCode();
+		timer.stop();
+
+		interp.shutdown();
+	}
+}
+
+// Parsing, resolving and freeing the tree
+static void parser_large(Timer& timer, size_t n)
+{
+	compile_large(timer, n, Compiler::PARSER_ONLY);
+}
+
+// The same with the code generation
+static void compile_large_code(Timer& timer, size_t n)
+{
+	compile_large(timer, n, 0);
+}
+
+static const Benchmark g_benchmarks[] = {
+	{ "value.copy.int",         value_copy_int       },
+	{ "value.copy.str",         value_copy_str       },
+	{ "value.deepcopy.int",     value_deepcopy_int   },
+	{ "value.deepcopy.str",     value_deepcopy_str   },
+	{ "value.deepcopy.array16", value_deepcopy_array },
+	{ "value.clone",            value_clone          },
+	{ "env.activate.0",         env_activate_0       },
+	{ "env.activate.4",         env_activate_4       },
+	{ "env.activate.16",        env_activate_16      },
+	{ "intern.hit",             intern_hit           },
+	{ "intern.miss",            intern_miss          },
+	{ "refcount.single",        refcount             },
+#ifdef CLEVER_THREADS
+	{ "refcount.shared",        refcount_shared      },
+	{ "refcount.private",       refcount_private     },
+#endif
+	{ "array.push",             array_push           },
+	{ "map.insert",             map_insert           },
+	{ "map.find",               map_find             },
+	{ "context.call",           context_call         },
+	{ "context.reset",          context_reset        },
+	{ "startup.trivial",        startup_trivial      },
+	{ "parser.large",           parser_large         },
+	{ "compile.large",          compile_large_code   }
+};
+
+static const size_t NUM_BENCHMARKS = sizeof(g_benchmarks) / sizeof(g_benchmarks[0]);
+
+// Iterations to run for about `target' nanoseconds
+static size_t calibrate(const Benchmark& bench, nsecs_t target)
+{
+	size_t n = 1;
+
+	while (true) {
+		Timer timer;
+
+		bench.func(timer, n);
+
+		if (timer.elapsed() >= target / 2 || n >= (size_t(1) << 30)) {
+			double scale = timer.elapsed() ? double(target) / timer.elapsed() : 2;
+
+			return std::max(size_t(1), size_t(n * scale));
+		}
+		n *= 8;
+	}
+}
+
+static bool matches(const char* name, const std::vector<std::string>& filters)
+{
+	if (filters.empty()) {
+		return true;
+	}
+
+	for (size_t i = 0, j = filters.size(); i < j; ++i) {
+		if (strncmp(name, filters[i].c_str(), filters[i].size()) == 0) {
+			return true;
+		}
+	}
+	return false;
+}
+
+// Median ns/op of each benchmark of a previous run
+static bool load_baseline(const char* file, std::map<std::string, double>& baseline)
+{
+	std::ifstream in(file);
+	std::string line;
+
+	if (!in) {
+		return false;
+	}
+
+	while (std::getline(in, line)) {
+		std::istringstream fields(line);
+		std::string name;
+		size_t iterations;
+		double median;
+
+		if (line.empty() || line[0] == '#') {
+			continue;
+		}
+
+		if (fields >> name >> iterations >> median) {
+			baseline[name] = median;
+		}
+	}
+	return true;
+}
+
+static void usage()
+{
+	std::cerr << "Usage: microbench [options] [filter ...]\n"
+		"  -s <samples>   samples of each benchmark (default: 5)\n"
+		"  -t <ms>        time of each sample (default: 20)\n"
+		"  -j <threads>   threads of the multi-threaded benchmarks (default: 4)\n"
+		"  -b <file>      output of a previous run to compare with\n"
+		"  -l             lists the benchmarks\n";
+}
+
+int main(int argc, char** argv)
+{
+	size_t samples = 5;
+	nsecs_t sample_time = 20;
+	const char* baseline_file = NULL;
+	std::vector<std::string> filters;
+	std::map<std::string, double> baseline;
+
+	for (int i = 1; i < argc; ++i) {
+		std::string arg(argv[i]);
+
+		if (arg == "-l") {
+			for (size_t j = 0; j < NUM_BENCHMARKS; ++j) {
+				std::cout << g_benchmarks[j].name << "\n";
+			}
+			return 0;
+		} else if (arg[0] != '-') {
+			filters.push_back(arg);
+			continue;
+		} else if (i + 1 == argc) {
+			usage();
+			return 2;
+		}
+
+		if (arg == "-s") {
+			samples = std::max(1, atoi(argv[++i]));
+		} else if (arg == "-t") {
+			sample_time = std::max(1, atoi(argv[++i]));
+		} else if (arg == "-j") {
+			g_threads = std::max(1, atoi(argv[++i]));
+		} else if (arg == "-b") {
+			baseline_file = argv[++i];
+		} else {
+			usage();
+			return 2;
+		}
+	}
+
+	if (baseline_file && !load_baseline(baseline_file, baseline)) {
+		std::cerr << "Couldn't read the baseline '" << baseline_file << "'\n";
+		return 2;
+	}
+
+	// The benchmarks run in the isolate of the program, where compiling
+	// imports std.core, which creates the native types
+	IsolateScope scope(g_program.getIsolate());
+
+	if (!g_program.loadStr("var calls = 0;\n"
+		"function add(a, b) { ++calls; return a + b; }\n")) {
+		return 1;
+	}
+
+	std::cout << "# " << samples << " samples of " << sample_time << " ms, "
+		<< g_threads << " threads\n"
+		<< "# " << std::left << std::setw(22) << "benchmark" << std::right
+		<< std::setw(12) << "iterations" << std::setw(14) << "ns/op"
+		<< std::setw(14) << "min ns/op";
+
+	if (baseline_file) {
+		std::cout << std::setw(14) << "base ns/op" << std::setw(10) << "change";
+	}
+	std::cout << "\n";
+
+	for (size_t i = 0; i < NUM_BENCHMARKS; ++i) {
+		const Benchmark& bench = g_benchmarks[i];
+
+		if (!matches(bench.name, filters)) {
+			continue;
+		}
+
+		size_t n = calibrate(bench, sample_time * 1000000);
+		std::vector<double> times(samples);
+
+		for (size_t j = 0; j < samples; ++j) {
+			Timer timer;
+
+			bench.func(timer, n);
+
+			times[j] = double(timer.elapsed()) / n;
+		}
+
+		std::sort(times.begin(), times.end());
+
+		double median = samples % 2 ? times[samples / 2]
+			: (times[samples / 2 - 1] + times[samples / 2]) / 2;
+
+		std::cout << std::left << std::setw(24) << bench.name << std::right
+			<< std::setw(12) << n << std::fixed << std::setprecision(2)
+			<< std::setw(14) << median << std::setw(14) << times[0];
+
+		if (baseline_file) {
+			std::map<std::string, double>::const_iterator base = baseline.find(bench.name);
+
+			if (base != baseline.end() && base->second > 0) {
+				std::cout << std::setw(14) << base->second << std::showpos
+					<< std::setw(9) << (median - base->second) * 100 / base->second
+					<< "%" << std::noshowpos;
+			} else {
+				std::cout << std::setw(14) << "-" << std::setw(10) << "new";
+			}
+		}
+		std::cout << std::endl;
+	}
+
+	g_program.shutdown();
+
+	return 0;
+}
@@ -0,0 +1,83 @@
+#!/bin/bash
+#
+# Clever programming language
+# Copyright (c) Clever Team
+#
+# This file is distributed under the MIT license. See LICENSE for details.
+#
+# run.sh - Measures the startup time of the interpreter
+#
+# Usage: run.sh [options]
+#
+#   -c <clever>    interpreter to benchmark (default: the one in the build
+#                  directory, ../../clever, or clever from the PATH)
+#   -n <runs>      runs of the script (default: 100)
+#   -s <socket>    also runs it through clever-client, with the script
+#                  server (clever --server) listening on <socket>
+#
+# Reports the mean wall time of running trivial.clv, which imports std.io
+# and prints a line, minus the one of running `true': what is left is the
+# time to start the process, register the packages, import the modules,
+# compile, run and shut down.
+
+cd "$(dirname "$0")" || exit 1
+
+clever=
+runs=100
+socket=
+
+while getopts "c:n:s:h" opt; do
+	case $opt in
+		c) clever=$OPTARG ;;
+		n) runs=$OPTARG ;;
+		s) socket=$OPTARG ;;
+		*) sed -n '10,21s/^# \{0,1\}//p' "$0"; exit 2 ;;
+	esac
+done
+
+if [ -z "$clever" ]; then
+	if [ -x ../../clever ]; then
+		clever=../../clever
+	else
+		clever=clever
+	fi
+fi
+
+if ! "$clever" trivial.clv > /dev/null 2>&1; then
+	echo "Couldn't run the interpreter '$clever'" >&2
+	exit 2
+fi
+
+# Mean time of a run of the command, in microseconds
+mean_us() {
+	local start end
+
+	start=$(date +%s%N)
+	for ((i = 0; i < runs; ++i)); do
+		"$@" > /dev/null
+	done
+	end=$(date +%s%N)
+
+	echo $(((end - start) / runs / 1000))
+}
+
+report() {
+	printf "%-14s %5d.%03d ms\n" "$1" $(($2 / 1000)) $(($2 % 1000))
+}
+
+base=$(mean_us "$(type -P true)")
+
+echo "# mean of $runs runs, minus the $base us of running true"
+
+report clever $(($(mean_us "$clever" trivial.clv) - base))
+
+if [ -n "$socket" ]; then
+	client=$(dirname "$clever")/clever-client
+
+	if [ ! -x "$client" ]; then
+		client=clever-client
+	fi
+
+	report clever-client \
+		$(($(CLEVER_SERVER=$socket mean_us "$client" trivial.clv) - base))
+fi
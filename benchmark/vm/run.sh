@@ -0,0 +1,181 @@
+#!/bin/bash
+#
+# Clever programming language
+# Copyright (c) Clever Team
+#
+# This file is distributed under the MIT license. See LICENSE for details.
+#
+# run.sh - Runs the VM benchmarks and writes their results as JSON
+#
+# Usage: run.sh [options] [benchmark ...]
+#
+#   -c <clever>    interpreter to benchmark (default: the one in the build
+#                  directory, ../../clever, or clever from the PATH)
+#   -o <file>      results file (default: results.json)
+#   -n <runs>      runs of each benchmark, the fastest is kept (default: 3)
+#   -b <baseline>  compares the results with a previous results file and
+#                  exits with status 1 if any benchmark regressed
+#   -t <percent>   change in time or peak RSS that counts as a regression
+#                  (default: 10)
+#   -q             quick run, with a hundredth of the iterations
+#
+# Every benchmark runs in its own process, so that the peak RSS is its own.
+# The benchmarks are the *.clv files of this directory, each measuring one
+# hot path of the interpreter; see _lib/harness.clv for what they report.
+
+cd "$(dirname "$0")" || exit 1
+
+clever=
+output=results.json
+runs=3
+baseline=
+threshold=10
+
+while getopts "c:o:n:b:t:qh" opt; do
+	case $opt in
+		c) clever=$OPTARG ;;
+		o) output=$OPTARG ;;
+		n) runs=$OPTARG ;;
+		b) baseline=$OPTARG ;;
+		t) threshold=$OPTARG ;;
+		q) export CLEVER_BENCH_QUICK=1 ;;
+		*) sed -n '10,24s/^# \{0,1\}//p' "$0"; exit 2 ;;
+	esac
+done
+shift $((OPTIND - 1))
+
+if [ -z "$clever" ]; then
+	if [ -x ../../clever ]; then
+		clever=../../clever
+	else
+		clever=clever
+	fi
+fi
+
+if ! "$clever" -v > /dev/null 2>&1; then
+	echo "Couldn't run the interpreter '$clever'" >&2
+	exit 2
+fi
+
+if [ -n "$baseline" ] && [ ! -r "$baseline" ]; then
+	echo "Couldn't read the baseline '$baseline'" >&2
+	exit 2
+fi
+
+if [ $# -eq 0 ]; then
+	set -- *.clv
+fi
+
+results=()
+
+for bench in "$@"; do
+	bench=${bench%.clv}
+	best=
+
+	printf "%-12s" "$bench" >&2
+
+	for ((i = 0; i < runs; ++i)); do
+		line=$("$clever" "$bench.clv" | grep '^{')
+
+		if [ -z "$line" ]; then
+			echo " failed" >&2
+			exit 2
+		fi
+
+		time_ns=$(echo "$line" | sed 's/.*"time_ns": \([0-9]*\).*/\1/')
+
+		if [ -z "$best" ] || [ "$time_ns" -lt "$best" ]; then
+			best=$time_ns
+			best_line=$line
+		fi
+		printf " ." >&2
+	done
+
+	printf " %d ms\n" $((best / 1000000)) >&2
+	results+=("$best_line")
+done
+
+{
+	echo "{"
+	echo "  \"clever\": \"$("$clever" -v 2>&1 | head -1 | sed 's/["\\]/\\&/g')\","
+	echo "  \"date\": \"$(date -u +%Y-%m-%dT%H:%M:%SZ)\","
+	echo "  \"runs\": $runs,"
+	echo "  \"quick\": $([ -n "$CLEVER_BENCH_QUICK" ] && echo true || echo false),"
+	echo "  \"benchmarks\": ["
+	for ((i = 0; i < ${#results[@]}; ++i)); do
+		sep=$([ $((i + 1)) -lt ${#results[@]} ] && echo ",")
+		echo "    ${results[$i]}$sep"
+	done
+	echo "  ]"
+	echo "}"
+} > "$output"
+
+echo "Results written to $output" >&2
+
+if [ -z "$baseline" ]; then
+	exit 0
+fi
+
+# Both files have a benchmark per line, as written above
+awk -v threshold="$threshold" '
+function field(line, key,    value) {
+	if (!match(line, "\"" key "\": (\"[^\"]*\"|[^,}]*)")) {
+		return ""
+	}
+	value = substr(line, RSTART + length(key) + 4, RLENGTH - length(key) - 4)
+	gsub(/"/, "", value)
+	return value
+}
+
+function change(before, after) {
+	return before > 0 ? (after - before) * 100 / before : 0
+}
+
+FNR == NR {
+	if ((name = field($0, "name")) != "") {
+		base_time[name] = field($0, "time_ns")
+		base_rss[name] = field($0, "peak_rss_kb")
+		base_iter[name] = field($0, "iterations")
+		base_sum[name] = field($0, "checksum")
+	}
+	next
+}
+
+(name = field($0, "name")) != "" {
+	if (!header++) {
+		printf "\n%-12s %12s %12s %8s %8s\n", "benchmark", "baseline ms", "current ms",
+			"time", "rss"
+	}
+
+	if (!(name in base_time)) {
+		printf "%-12s %12s %12.3f %8s %8s  new\n", name, "-", field($0, "time_ns") / 1e6,
+			"", ""
+		next
+	}
+
+	if (base_iter[name] != field($0, "iterations")) {
+		printf "%-12s  different iterations, not comparable\n", name
+		next
+	}
+
+	time = change(base_time[name], field($0, "time_ns"))
+	rss = change(base_rss[name], field($0, "peak_rss_kb"))
+	status = ""
+
+	if (base_sum[name] != field($0, "checksum")) {
+		status = "CHECKSUM MISMATCH"
+		failed = 1
+	} else if (time > threshold || rss > threshold) {
+		status = "REGRESSION"
+		failed = 1
+	} else if (time < -threshold) {
+		status = "improved"
+	}
+
+	printf "%-12s %12.3f %12.3f %+7.1f%% %+7.1f%%%s\n", name, base_time[name] / 1e6,
+		field($0, "time_ns") / 1e6, time, rss, status != "" ? "  " status : ""
+}
+
+END {
+	exit failed
+}' "$baseline" "$output"
@@ -48,10 +48,14 @@ endmacro()
 # clever_new_module(<name> <enabled>
 # 		[[DOC <doc string>]
 # 		 [LIBS <library variable names>]
-# 		 [MODS <module names>]]
+# 		 [MODS <module names>]
+# 		 [PLUGIN]]
 #
 # Declares a new clever module.
 #
+# PLUGIN modules are built as shared objects, loaded when imported, when
+# SHARED_MODULES is set. Only them link their libraries then.
+#
 # Example:
 # 	clever_new_module(std.regex ON
 # 		DOC "perl-compatible regex module"
@@ -67,11 +71,13 @@ endmacro()
 #         <Uppercased Name>_CHECKED (OFF by default)
 #         <Uppercased Name>_MOD_DEPENDS
 #         <Uppercased Name>_LIB_DEPENDS
+#         <Uppercased Name>_PLUGIN
 #
 macro(clever_new_module Name Enabled)
+	set(options PLUGIN)
 	set(singleValue DOC PATH)
 	set(multiValue LIBS MODS)
-	cmake_parse_arguments(args "" "${singleValue}" "${multiValue}" ${ARGN})
+	cmake_parse_arguments(args "${options}" "${singleValue}" "${multiValue}" ${ARGN})
 
 	clever_module_var(${Name} _mod_var)
 	clever_module_path(${Name} _mod_path PATH "${args_PATH}")
@@ -83,6 +89,12 @@ macro(clever_new_module Name Enabled)
 	clever_module_set_prop(${Name} MOD_DEPENDS "${args_MODS}")
 	clever_module_set_prop(${Name} LIB_DEPENDS "${args_LIBS}")
 
+	if(SHARED_MODULES AND args_PLUGIN)
+		clever_module_set_prop(${Name} PLUGIN ON)
+	else()
+		clever_module_set_prop(${Name} PLUGIN OFF)
+	endif()
+
 
 	list(APPEND CLEVER_AVAILABLE_MODULES ${Name})
 
@@ -148,7 +160,19 @@ macro(clever_module_check Name)
 			endforeach()
 		endif()
 
-		if(${_mod_var})
+		if(${_mod_var} AND ${_mod_var}_PLUGIN)
+			# only the plugin links the libs
+			set(${_mod_var}_PLUGIN_LIBRARIES)
+			foreach(_name ${${_mod_libs}})
+				list(APPEND CLEVER_INCLUDE_DIRS ${${_name}_INCLUDE_DIRS})
+				list(APPEND CLEVER_LINK_DIRECTORIES ${${_name}_LINK_DIRECTORIES})
+				list(APPEND ${_mod_var}_PLUGIN_LIBRARIES ${${_name}_LIBRARIES})
+			endforeach()
+
+			add_definitions(-DHAVE_PLUGIN_${_mod_var})
+
+			clever_module_msg(${Name} "enabled (plugin)")
+		elseif(${_mod_var})
 			# use the libs
 			foreach(_name ${${_mod_libs}})
 				clever_use_lib(${_name})
@@ -163,6 +187,57 @@ macro(clever_module_check Name)
 	endif()
 endmacro()
 
+# clever_add_module(<name> <target> <sources>...)
+#
+# Adds the library of a module: a static library linked into the runtime,
+# or a shared object named after the module (e.g. db_sqlite3.so) when it is
+# built as a plugin.
+#
+macro(clever_add_module Name Target)
+	clever_module_var(${Name} _mod_var)
+
+	if(${_mod_var}_PLUGIN)
+		string(REPLACE "." "_" _plugin_name "${Name}")
+
+		add_library(${Target} MODULE ${ARGN})
+		set_target_properties(${Target} PROPERTIES
+			PREFIX ""
+			SUFFIX ".so"
+			OUTPUT_NAME "${_plugin_name}"
+			COMPILE_DEFINITIONS CLEVER_PLUGIN
+			LIBRARY_OUTPUT_DIRECTORY "${CMAKE_BINARY_DIR}/plugins")
+
+		# the runtime symbols come from the executable
+		if(APPLE)
+			set_target_properties(${Target} PROPERTIES
+				LINK_FLAGS "-undefined dynamic_lookup")
+		endif()
+
+		target_link_libraries(${Target} ${${_mod_var}_PLUGIN_LIBRARIES})
+
+		install(TARGETS ${Target} LIBRARY DESTINATION ${CLEVER_MODULE_DIR})
+	else()
+		add_library(${Target} STATIC ${ARGN})
+	endif()
+endmacro()
+
+# clever_link_modules(<target> <prefix> <modules>...)
+#
+# Links the static modules into the library of their package, the plugins
+# are only built along with it.
+#
+macro(clever_link_modules Target Prefix)
+	foreach(_module ${ARGN})
+		add_dependencies(${Target} "${Prefix}_${_module}")
+
+		get_target_property(_type "${Prefix}_${_module}" TYPE)
+
+		if(_type STREQUAL "STATIC_LIBRARY")
+			target_link_libraries(${Target} "${Prefix}_${_module}")
+		endif()
+	endforeach()
+endmacro()
+
 # clever_add_lib(<var_name>
 #       [PKGS pkg1 [pkg2 ...]]
 #       [LIBS lib1 [lib2 ...]]
@@ -0,0 +1,45 @@
+/**
+ * Clever programming language
+ * Copyright (c) Clever Team
+ *
+ * This file is distributed under the MIT license. See LICENSE for details.
+ */
+
+#include "core/arena.h"
+
+namespace clever {
+
+THREAD_TLS Arena* Arena::s_current = NULL;
+
+void* Arena::allocSlow(size_t size)
+{
+	// Large requests don't waste what is left of the current chunk
+	if (size > CHUNK_SIZE / 4) {
+		char* chunk = new char[size];
+
+		m_chunks.push_back(chunk);
+		m_size += size;
+		return chunk;
+	}
+
+	char* chunk = new char[CHUNK_SIZE];
+
+	m_chunks.push_back(chunk);
+	m_ptr = chunk + size;
+	m_end = chunk + CHUNK_SIZE;
+	m_size += size;
+	return chunk;
+}
+
+void Arena::release()
+{
+	for (size_t i = 0, j = m_chunks.size(); i < j; ++i) {
+		delete[] m_chunks[i];
+	}
+	m_chunks.clear();
+
+	m_ptr = m_end = NULL;
+	m_size = 0;
+}
+
+} // clever
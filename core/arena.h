@@ -0,0 +1,147 @@
+/**
+ * Clever programming language
+ * Copyright (c) Clever Team
+ *
+ * This file is distributed under the MIT license. See LICENSE for details.
+ */
+
+#ifndef CLEVER_ARENA_H
+#define CLEVER_ARENA_H
+
+#include <cstddef>
+#include <new>
+#include <vector>
+#include "core/clever.h"
+
+namespace clever {
+
+/**
+ * @brief a bump allocator whose memory is freed all at once.
+ *
+ * The compiler allocates the syntax tree of a script from an arena, which is
+ * released once its code is generated, instead of freeing every node. The
+ * memory is taken from the system in chunks; the requests larger than a
+ * fraction of a chunk get a chunk of their own.
+ *
+ * Nothing is ever destroyed: the objects allocated from an arena must not
+ * own memory allocated anywhere else (see ArenaAllocator for their vectors).
+ *
+ * Each thread has a current arena, entered with ArenaScope.
+ */
+class Arena {
+public:
+	/// Size of the chunks taken from the system
+	static const size_t CHUNK_SIZE = 64 * 1024;
+
+	/// Alignment of the allocations, the one of malloc()
+	static const size_t ALIGNMENT = 2 * sizeof(void*);
+
+	Arena()
+		: m_chunks(), m_ptr(NULL), m_end(NULL), m_size(0) {}
+
+	~Arena() { release(); }
+
+	void* alloc(size_t size) {
+		size = (size + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+
+		if (EXPECTED(size <= size_t(m_end - m_ptr))) {
+			void* ptr = m_ptr;
+
+			m_ptr += size;
+			m_size += size;
+			return ptr;
+		}
+		return allocSlow(size);
+	}
+
+	/// Frees everything allocated so far, the arena can be used again
+	void release();
+
+	/// Bytes allocated since the last release
+	size_t getSize() const { return m_size; }
+
+	/// Returns the arena entered by the current thread, NULL if none
+	static Arena* getCurrent() { return s_current; }
+	static void setCurrent(Arena* arena) { s_current = arena; }
+private:
+	void* allocSlow(size_t size);
+
+	std::vector<char*> m_chunks;
+
+	// Free space of the current chunk
+	char* m_ptr;
+	char* m_end;
+
+	size_t m_size;
+
+	/// Arena entered by the current thread
+	static THREAD_TLS Arena* s_current;
+
+	DISALLOW_COPY_AND_ASSIGN(Arena);
+};
+
+/// Enters an arena on the current thread for the lifetime of the scope
+class ArenaScope {
+public:
+	explicit ArenaScope(Arena* arena)
+		: m_prev(Arena::getCurrent()) {
+		Arena::setCurrent(arena);
+	}
+
+	~ArenaScope() {
+		Arena::setCurrent(m_prev);
+	}
+private:
+	Arena* m_prev;
+
+	DISALLOW_COPY_AND_ASSIGN(ArenaScope);
+};
+
+/// Standard allocator taking the memory from the current arena, for the
+/// containers of the objects living in it. The memory released by the
+/// container (e.g. when a vector grows) is only reclaimed with the arena.
+template <typename T>
+class ArenaAllocator {
+public:
+	typedef T value_type;
+	typedef T* pointer;
+	typedef const T* const_pointer;
+	typedef T& reference;
+	typedef const T& const_reference;
+	typedef size_t size_type;
+	typedef ptrdiff_t difference_type;
+
+	template <typename U>
+	struct rebind { typedef ArenaAllocator<U> other; };
+
+	ArenaAllocator() {}
+
+	template <typename U>
+	ArenaAllocator(const ArenaAllocator<U>&) {}
+
+	pointer address(reference x) const { return &x; }
+	const_pointer address(const_reference x) const { return &x; }
+
+	pointer allocate(size_type n, const void* = 0) {
+		clever_assert_not_null(Arena::getCurrent());
+
+		return static_cast<pointer>(Arena::getCurrent()->alloc(n * sizeof(T)));
+	}
+
+	void deallocate(pointer, size_type) {}
+
+	size_type max_size() const { return size_t(-1) / sizeof(T); }
+
+	void construct(pointer p, const T& val) { new (static_cast<void*>(p)) T(val); }
+	void destroy(pointer p) { p->~T(); }
+};
+
+template <typename T, typename U>
+inline bool operator==(const ArenaAllocator<T>&, const ArenaAllocator<U>&) { return true; }
+
+template <typename T, typename U>
+inline bool operator!=(const ArenaAllocator<T>&, const ArenaAllocator<U>&) { return false; }
+
+} // clever
+
+#endif // CLEVER_ARENA_H
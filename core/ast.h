@@ -9,6 +9,7 @@
 #define CLEVER_AST_H
 
 #include <vector>
+#include "core/arena.h"
 #include "core/value.h"
 #include "core/location.hh"
 #include "core/clever.h"
@@ -49,18 +50,30 @@ class Break;
 class Continue;
 class AttrDecl;
 
-typedef std::vector<Node*> NodeList;
+typedef std::vector<Node*, ArenaAllocator<Node*> > NodeList;
+typedef std::pair<Node*, Node*> NodePair;
+typedef std::vector<NodePair, ArenaAllocator<NodePair> > NodePairList;
 
 class Visitor;
 class Transformer;
 
-class Node: public RefCounted {
+/// The nodes are allocated from the current arena, entered by the compiler,
+/// and freed all together with it once the code is generated
+class Node {
 public:
 	Node(const location& location)
-		: RefCounted(0), m_location(location), m_scope(NULL), m_voffset(0,0) {}
+		: m_location(location), m_scope(NULL), m_voffset(0,0) {}
 
 	virtual ~Node() {}
 
+	static void* operator new(size_t size) {
+		clever_assert_not_null(Arena::getCurrent());
+
+		return Arena::getCurrent()->alloc(size);
+	}
+
+	static void operator delete(void*) {}
+
 	virtual void accept(Visitor& visitor);
 	virtual Node* accept(Transformer& transformer);
 
@@ -93,8 +106,6 @@ public:
 	NodeArray(const location& location)
 		: Node(location), m_nodes() {}
 
-	virtual ~NodeArray() { clearNodes(); }
-
 	NodeList& getNodes() { return m_nodes; }
 
 	Node* getFirst() {
@@ -117,7 +128,6 @@ public:
 
 	Node* append(Node* node) {
 		m_nodes.push_back(node);
-		node->addRef();
 		return node;
 	}
 
@@ -125,15 +135,6 @@ public:
 
 	virtual void accept(Visitor& visitor);
 	virtual Node* accept(Transformer& transformer);
-
-	void clearNodes() {
-		NodeList::iterator it(m_nodes.begin()), end(m_nodes.end());
-
-		while (it != end) {
-			(*it)->delRef();
-			++it;
-		}
-	}
 protected:
 	NodeList m_nodes;
 };
@@ -159,15 +160,7 @@ public:
 	};
 
 	Comparison(ComparisonOperator op, Node* lhs, Node* rhs, const location& location)
-		: Node(location), m_op(op), m_lhs(lhs), m_rhs(rhs) {
-		m_lhs->addRef();
-		m_rhs->addRef();
-	}
-
-	~Comparison() {
-		m_lhs->delRef();
-		m_rhs->delRef();
-	}
+		: Node(location), m_op(op), m_lhs(lhs), m_rhs(rhs) {}
 
 	ComparisonOperator getOperator() const { return m_op; }
 
@@ -187,19 +180,10 @@ private:
 class Assignment: public Node {
 public:
 	Assignment(Node* lhs, Node* rhs, const location& location)
-		: Node(location), m_conditional(false), m_result(false), m_lhs(lhs), m_rhs(rhs) {
-		m_lhs->addRef();
-		clever_addref(m_rhs);
-	}
-
-	~Assignment() {
-		m_lhs->delRef();
-		clever_delref(m_rhs);
-	}
+		: Node(location), m_conditional(false), m_result(false), m_lhs(lhs), m_rhs(rhs) {}
 
 	void setRhs(Node* rhs) {
 		m_rhs = rhs;
-		clever_addref(m_rhs);
 	}
 
 	Node* getLhs() const { return m_lhs; }
@@ -243,7 +227,6 @@ public:
 
 	void append(char separator, ast::Type* ident) {
 		m_name = CSTRING(*m_name + separator + *ident->getName());
-		clever_delete(ident);
 	}
 private:
 	const CString* m_name;
@@ -266,12 +249,10 @@ public:
 
 	void append(char separator, Ident* ident) {
 		m_name = CSTRING(*m_name + separator + *ident->getName());
-		clever_delete(ident);
 	}
 
 	void append(char separator, ast::Type* ident) {
 		m_name = CSTRING(*m_name + separator + *ident->getName());
-		clever_delete(ident);
 	}
 
 	virtual void accept(Visitor& visitor);
@@ -286,13 +267,7 @@ private:
 class CriticalBlock: public NodeArray {
 public:
 	CriticalBlock(Block* block, const location& location)
-		: NodeArray(location), m_block(block) {
-		m_block->addRef();
-	}
-
-	~CriticalBlock() {
-		m_block->delRef();
-	}
+		: NodeArray(location), m_block(block) {}
 
 	virtual void accept(Visitor& visitor);
 	virtual Node* accept(Transformer& transformer);
@@ -307,28 +282,13 @@ private:
 class Instantiation: public Node {
 public:
 	Instantiation(const CString* type, NodeArray* args, const location& location)
-		: Node(location), m_type(new Type(type, location)), m_args(args) {
-		m_type->addRef();
-		clever_addref(m_args);
-	}
+		: Node(location), m_type(new Type(type, location)), m_args(args) {}
 
 	Instantiation(Ident* type, NodeArray* args, const location& location)
-		: Node(location), m_type(new Type(type->getName(), location)), m_args(args) {
-		m_type->addRef();
-		clever_delete(type);
-		clever_addref(m_args);
-	}
+		: Node(location), m_type(new Type(type->getName(), location)), m_args(args) {}
 
 	Instantiation(Type* type, NodeArray* args, const location& location)
-		: Node(location), m_type(type), m_args(args) {
-		m_type->addRef();
-		clever_addref(m_args);
-	}
-
-	~Instantiation() {
-		m_type->delRef();
-		clever_delref(m_args);
-	}
+		: Node(location), m_type(type), m_args(args) {}
 
 	Type* getType() const { return m_type; }
 
@@ -354,30 +314,15 @@ class Import: public Node {
 public:
 	Import(Ident* name, const location& location)
 		: Node(location), m_module(name), m_func(NULL), m_type(NULL),
-			m_namespaced(false) {
-		clever_addref(m_module);
-	}
+			m_tree(NULL), m_namespaced(false) {}
 
 	Import(Ident* name, Ident* func, const location& location)
 		: Node(location), m_module(name), m_func(func), m_type(NULL),
-			m_tree(NULL), m_namespaced(false) {
-		clever_addref(m_module);
-		m_func->addRef();
-	}
+			m_tree(NULL), m_namespaced(false) {}
 
 	Import(Ident* module, Type* type, const location& location)
 		: Node(location), m_module(module), m_func(NULL), m_type(type),
-			m_tree(NULL), m_namespaced(false) {
-		clever_addref(m_module);
-		m_type->addRef();
-	}
-
-	~Import() {
-		clever_delref(m_module);
-		clever_delref(m_func);
-		clever_delref(m_type);
-		clever_delref(m_tree);
-	}
+			m_tree(NULL), m_namespaced(false) {}
 
 	Type* getType() const { return m_type; }
 	Ident* getFunction() const { return m_func; }
@@ -387,7 +332,6 @@ public:
 	bool hasModuleTree() const { return m_tree != NULL; }
 	void setModuleTree(Node* tree) {
 		m_tree = tree;
-		clever_addref(m_tree);
 	}
 	Node* getModuleTree() const { return m_tree; }
 
@@ -411,20 +355,11 @@ public:
 	VariableDecl(Ident* ident, Assignment* assignment, bool is_const,
 				 const location& location)
 		: Node(location), m_ident(ident), m_assignment(assignment),
-		  m_is_const(is_const) {
-		m_ident->addRef();
-		clever_addref(m_assignment);
-	}
-
-	~VariableDecl() {
-		m_ident->delRef();
-		clever_delref(m_assignment);
-	}
+		  m_is_const(is_const) {}
 
 	Ident* getIdent() const { return m_ident; }
 	void setAssignment(Assignment* assignment) {
 		m_assignment = assignment;
-		clever_addref(m_assignment);
 	}
 
 	Assignment* getAssignment() const { return m_assignment; }
@@ -454,15 +389,7 @@ public:
 	};
 
 	Arithmetic(ArithOperator op, Node* lhs, Node* rhs, const location& location, bool is_augmented = false)
-		: Node(location), m_op(op), m_lhs(lhs), m_rhs(rhs), m_is_augmented(is_augmented) {
-		m_lhs->addRef();
-		m_rhs->addRef();
-	}
-
-	~Arithmetic() {
-		m_lhs->delRef();
-		m_rhs->delRef();
-	}
+		: Node(location), m_op(op), m_lhs(lhs), m_rhs(rhs), m_is_augmented(is_augmented) {}
 
 	ArithOperator getOperator() const { return m_op; }
 	Node* getLhs() const { return m_lhs; }
@@ -491,15 +418,7 @@ public:
 	};
 
 	Logic(LogicOperator op, Node* lhs, Node* rhs, const location& location)
-		: Node(location), m_op(op), m_lhs(lhs), m_rhs(rhs) {
-		m_lhs->addRef();
-		m_rhs->addRef();
-	}
-
-	~Logic() {
-		m_lhs->delRef();
-		m_rhs->delRef();
-	}
+		: Node(location), m_op(op), m_lhs(lhs), m_rhs(rhs) {}
 
 	bool isEvaluable() const { return true; }
 
@@ -527,20 +446,10 @@ public:
 	};
 
 	Boolean(BooleanOperator op, Node* lhs, Node* rhs, const location& location)
-		: Node(location), m_op(op), m_lhs(lhs), m_rhs(rhs) {
-		clever_addref(m_lhs);
-		clever_addref(m_rhs);
-	}
+		: Node(location), m_op(op), m_lhs(lhs), m_rhs(rhs) {}
 
 	Boolean(BooleanOperator op, Node* lhs, const location& location)
-		: Node(location), m_op(op), m_lhs(lhs), m_rhs(NULL) {
-		clever_addref(m_lhs);
-	}
-
-	~Boolean() {
-		clever_delref(m_lhs);
-		clever_delref(m_rhs);
-	}
+		: Node(location), m_op(op), m_lhs(lhs), m_rhs(NULL) {}
 
 	BooleanOperator getOperator() const { return m_op; }
 	Node* getLhs() const { return m_lhs; }
@@ -570,20 +479,10 @@ public:
 	};
 
 	Bitwise(BitwiseOperator op, Node* lhs, Node* rhs, const location& location, bool is_augmented = false)
-		: Node(location), m_op(op), m_lhs(lhs), m_rhs(rhs), m_is_augmented(is_augmented) {
-		m_lhs->addRef();
-		m_rhs->addRef();
-	}
+		: Node(location), m_op(op), m_lhs(lhs), m_rhs(rhs), m_is_augmented(is_augmented) {}
 
 	Bitwise(BitwiseOperator op, Node* lhs, const location& location)
-		: Node(location), m_op(op), m_lhs(lhs), m_rhs(NULL), m_is_augmented(false) {
-		m_lhs->addRef();
-	}
-
-	~Bitwise() {
-		m_lhs->delRef();
-		m_rhs->delRef();
-	}
+		: Node(location), m_op(op), m_lhs(lhs), m_rhs(NULL), m_is_augmented(false) {}
 
 	bool isEvaluable() const { return true; }
 	bool isAugmented() const { return m_is_augmented; }
@@ -615,42 +514,20 @@ public:
 		VariableDecl* vararg, bool is_anon, const location& location)
 		: Node(location), m_ident(ident), m_type(NULL), m_args(args), m_block(block),
 			m_vararg(vararg), m_is_anon(is_anon), m_is_ctor(false), m_is_dtor(false),
-			m_is_static(false), m_visibility(0), m_func(NULL) {
-		clever_addref(m_ident);
-		clever_addref(m_args);
-		clever_addref(m_block);
-		clever_addref(m_vararg);
-	}
+			m_is_static(false), m_visibility(0), m_func(NULL) {}
 
 	FunctionDecl(Type* type, NodeArray* args, Block* block, VariableDecl* vararg,
 		const location& location)
 		: Node(location), m_ident(NULL), m_type(type), m_args(args), m_block(block),
 			m_vararg(vararg), m_is_anon(false), m_is_ctor(false), m_is_dtor(false),
-			m_is_static(false), m_visibility(0), m_func(NULL) {
-		clever_addref(m_type);
-		clever_addref(m_args);
-		clever_addref(m_block);
-		clever_addref(m_vararg);
-	}
-
-	~FunctionDecl() {
-		clever_delref(m_ident);
-		clever_delref(m_type);
-		clever_delref(m_args);
-		clever_delref(m_block);
-		clever_delref(m_vararg);
-	}
+			m_is_static(false), m_visibility(0), m_func(NULL) {}
 
 	void setIdent(Ident* ident) {
-		clever_delref(m_ident);
 		m_ident = ident;
-		clever_addref(m_ident);
 	}
 
 	void setType(Type* type) {
-		clever_delref(m_type);
 		m_type = type;
-		clever_addref(m_type);
 	}
 
 	void setVisibility(size_t flags) { m_visibility = flags; }
@@ -709,24 +586,10 @@ private:
 class MethodCall: public Node {
 public:
 	MethodCall(Node* callee, Ident* method, NodeArray* args, const location& location)
-		: Node(location), m_callee(callee), m_method(method), m_args(args), m_static(false) {
-		m_callee->addRef();
-		m_method->addRef();
-		clever_addref(m_args);
-	}
+		: Node(location), m_callee(callee), m_method(method), m_args(args), m_static(false) {}
 
 	MethodCall(Type* callee, Ident* method, NodeArray* args, const location& location)
-		: Node(location), m_callee(callee), m_method(method), m_args(args), m_static(true) {
-		m_callee->addRef();
-		m_method->addRef();
-		clever_addref(m_args);
-	}
-
-	~MethodCall() {
-		m_callee->delRef();
-		m_method->delRef();
-		clever_delref(m_args);
-	}
+		: Node(location), m_callee(callee), m_method(method), m_args(args), m_static(true) {}
 
 	bool isStaticCall() const { return m_static; }
 	bool isEvaluable() const { return true; }
@@ -740,7 +603,7 @@ public:
 	size_t numArgs() const { return m_args->getSize(); }
 
 	Node* getArg(size_t index) {
-		std::vector<Node*> array = m_args->getNodes();
+		const NodeList& array = m_args->getNodes();
 
 		clever_assert(index > 0 && index < array.size(), "Index %i out of bounds.", index);
 
@@ -764,15 +627,7 @@ private:
 class FunctionCall: public Node {
 public:
 	FunctionCall(Node* callee, NodeArray* args, const location& location)
-		: Node(location), m_callee(callee), m_args(args) {
-		m_callee->addRef();
-		clever_addref(m_args);
-	}
-
-	~FunctionCall() {
-		m_callee->delRef();
-		clever_delref(m_args);
-	}
+		: Node(location), m_callee(callee), m_args(args) {}
 
 	Node* getCallee() const { return m_callee; }
 
@@ -783,7 +638,7 @@ public:
 	bool isEvaluable() const { return true; }
 
 	Node* getArg(size_t index) {
-		std::vector<Node*> array = m_args->getNodes();
+		const NodeList& array = m_args->getNodes();
 
 		clever_assert(index > 0 && index < array.size(), "Index %i out of bounds.", index);
 
@@ -806,15 +661,7 @@ private:
 class While: public Node {
 public:
 	While(Node* condition, Node* block, const location& location)
-		: Node(location), m_condition(condition), m_block(block) {
-		clever_addref(m_condition);
-		clever_addref(m_block);
-	}
-
-	~While() {
-		clever_delref(m_condition);
-		clever_delref(m_block);
-	}
+		: Node(location), m_condition(condition), m_block(block) {}
 
 	Node* getCondition() const { return m_condition; }
 	Node* getBlock() const { return m_block; }
@@ -831,15 +678,7 @@ private:
 class DoWhile: public Node {
 public:
 	DoWhile(Node* condition, Node* block, const location& location)
-		: Node(location), m_condition(condition), m_block(block) {
-		clever_addref(m_condition);
-		clever_addref(m_block);
-	}
-
-	~DoWhile() {
-		clever_delref(m_condition);
-		clever_delref(m_block);
-	}
+		: Node(location), m_condition(condition), m_block(block) {}
 
 	Node* getCondition() const { return m_condition; }
 	Node* getBlock() const { return m_block; }
@@ -856,19 +695,7 @@ private:
 class For: public Node {
 public:
 	For(NodeArray* initlist, Node* cond, NodeArray* update, Node* block, const location& location)
-		: Node(location),  m_init(initlist), m_condition(cond), m_update(update), m_block(block) {
-		clever_addref(m_init);
-		clever_addref(m_condition);
-		clever_addref(m_update);
-		clever_addref(m_block);
-	}
-
-	~For() {
-		clever_delref(m_init);
-		clever_delref(m_condition);
-		clever_delref(m_update);
-		clever_delref(m_block);
-	}
+		: Node(location),  m_init(initlist), m_condition(cond), m_update(update), m_block(block) {}
 
 	bool hasInitializer() const { return m_init != NULL; }
 	bool hasCondition() const { return m_condition != NULL; }
@@ -893,17 +720,7 @@ private:
 class ForEach: public Node {
 public:
 	ForEach(VariableDecl* var, Node* expr, Node* block, const location& location)
-		: Node(location), m_var(var), m_expr(expr), m_block(block) {
-		clever_addref(m_var);
-		clever_addref(m_expr);
-		clever_addref(m_block);
-	}
-
-	~ForEach() {
-		clever_delref(m_var);
-		clever_delref(m_expr);
-		clever_delref(m_block);
-	}
+		: Node(location), m_var(var), m_expr(expr), m_block(block) {}
 
 	VariableDecl* getVarDecl() const { return m_var; }
 	Node* getExpr() const { return m_expr; }
@@ -930,34 +747,16 @@ public:
 		addConditional(cond_node, then_node);
 	}
 
-	~If() {
-		std::vector<std::pair<Node*, Node*> >::const_iterator it(m_conditionals.begin()),
-				end(m_conditionals.end());
-
-		while (it != end) {
-			(*it).first->delRef();
-			(*it).second->delRef();
-			++it;
-		}
-		if (m_else_node) {
-			m_else_node->delRef();
-		}
-	}
-
 	void addConditional(Node* cond_node, Node* then_node) {
 		clever_assert_not_null(cond_node);
 
-		m_conditionals.push_back(std::pair<Node*,Node*>(cond_node, then_node));
-
-		cond_node->addRef();
-		then_node->addRef();
+		m_conditionals.push_back(NodePair(cond_node, then_node));
 	}
 
-	std::vector<std::pair<Node*, Node*> >& getConditionals() { return m_conditionals; }
+	NodePairList& getConditionals() { return m_conditionals; }
 
 	void setElseNode(Node* else_node) {
 		m_else_node = else_node;
-		m_else_node->addRef();
 	}
 
 	Node* getElseNode() const { return m_else_node; }
@@ -967,7 +766,7 @@ public:
 
 private:
 	Node* m_else_node;
-	std::vector<std::pair<Node*, Node*> > m_conditionals;
+	NodePairList m_conditionals;
 
 	DISALLOW_COPY_AND_ASSIGN(If);
 };
@@ -1065,13 +864,7 @@ public:
 class Return: public Node {
 public:
 	Return(Node* value, const location& location)
-		: Node(location), m_value(value) {
-		clever_addref(m_value);
-	}
-
-	~Return() {
-		clever_delref(m_value);
-	}
+		: Node(location), m_value(value) {}
 
 	bool hasValue() const { return m_value != NULL; }
 	Node* getValue() const { return m_value; }
@@ -1087,15 +880,7 @@ private:
 class Subscript: public Node {
 public:
 	Subscript(Node* var, Node* index, const location& location)
-		: Node(location), m_var(var), m_index(index), m_write(false) {
-		clever_addref(m_var);
-		clever_addref(m_index);
-	}
-
-	~Subscript() {
-		clever_delref(m_var);
-		clever_delref(m_index);
-	}
+		: Node(location), m_var(var), m_index(index), m_write(false) {}
 
 	bool isWriteMode() const { return m_write; }
 	void setWriteMode() { m_write = true; }
@@ -1119,22 +904,11 @@ public:
 
 	Property(Node* callee, Ident* prop_name, const location& location)
 		: Node(location), m_callee(callee), m_prop_name(prop_name),
-		  m_static(false), m_mode(READ) {
-		m_callee->addRef();
-		m_prop_name->addRef();
-	}
+		  m_static(false), m_mode(READ) {}
 
 	Property(Type* callee, Ident* prop_name, const location& location)
 		: Node(location), m_callee(callee), m_prop_name(prop_name),
-		  m_static(true), m_mode(READ) {
-		m_callee->addRef();
-		m_prop_name->addRef();
-	}
-
-	~Property() {
-		m_callee->delRef();
-		m_prop_name->delRef();
-	}
+		  m_static(true), m_mode(READ) {}
 
 	Node* getCallee() const { return m_callee; }
 	Ident* getProperty() const { return m_prop_name; }
@@ -1168,13 +942,7 @@ public:
 	};
 
 	IncDec(IncDecOperator op, Node* var, const location& location)
-		: Node(location), m_op(op), m_var(var) {
-		m_var->addRef();
-	}
-
-	~IncDec() {
-		m_var->delRef();
-	}
+		: Node(location), m_op(op), m_var(var) {}
 
 	bool isEvaluable() const { return true; }
 
@@ -1194,16 +962,7 @@ private:
 class Try: public Node {
 public:
 	Try(Block* try_block, NodeArray* catches, Block* finally, const location& location)
-		: Node(location), m_try(try_block), m_catch(catches), m_finally(finally) {
-		m_try->addRef();
-		clever_addref(m_catch);
-		clever_addref(m_finally);
-	}
-	~Try() {
-		m_try->delRef();
-		clever_delref(m_catch);
-		clever_delref(m_finally);
-	}
+		: Node(location), m_try(try_block), m_catch(catches), m_finally(finally) {}
 
 	Block* getBlock() const { return m_try; }
 
@@ -1225,15 +984,7 @@ private:
 class Catch: public Node {
 public:
 	Catch(Ident* var, Block* block, const location& location)
-		: Node(location), m_var(var), m_block(block) {
-		m_var->addRef();
-		m_block->addRef();
-	}
-
-	~Catch() {
-		m_var->delRef();
-		m_block->delRef();
-	}
+		: Node(location), m_var(var), m_block(block) {}
 
 	Ident* getVar() const { return m_var; }
 
@@ -1251,13 +1002,7 @@ private:
 class Throw: public Node {
 public:
 	Throw(Node* expr, const location& location)
-		: Node(location), m_expr(expr) {
-		m_expr->addRef();
-	}
-
-	~Throw() {
-		m_expr->delRef();
-	}
+		: Node(location), m_expr(expr) {}
 
 	Node* getExpr() const { return m_expr; }
 
@@ -1298,15 +1043,7 @@ private:
 class AttrDecl: public Node {
 public:
 	AttrDecl(Ident* ident, Node* value, bool is_const, const location& location)
-		: Node(location), m_ident(ident), m_value(value), m_const(is_const), m_visibility(0) {
-		m_ident->addRef();
-		clever_addref(m_value);
-	}
-
-	~AttrDecl() {
-		m_ident->delRef();
-		clever_delref(m_value);
-	}
+		: Node(location), m_ident(ident), m_value(value), m_const(is_const), m_visibility(0) {}
 
 	Ident* getIdent() const { return m_ident; }
 
@@ -1354,15 +1091,7 @@ private:
 class ClassDef: public Node {
 public:
 	ClassDef(Type* name, NodeArray* members, const location& location)
-		: Node(location), m_type(name), m_members(members) {
-		m_type->addRef();
-		clever_addref(m_members);
-	}
-
-	~ClassDef() {
-		m_type->delRef();
-		clever_delref(m_members);
-	}
+		: Node(location), m_type(name), m_members(members) {}
 
 	bool hasMembers() const { return m_members != NULL; }
 
@@ -1380,29 +1109,13 @@ private:
 class Switch: public Node {
 public:
 	Switch(Node* expr, const location& location)
-		: Node(location), m_expr(expr) {
-		clever_addref(m_expr);
-	}
-
-	~Switch() {
-		clever_delref(m_expr);
-
-		std::vector<std::pair<Node*, Node*> >::const_iterator it(m_cases.begin()),
-			end(m_cases.end());
-
-		for (; it != end; ++it) {
-			clever_delref(it->first);
-			clever_delref(it->second);
-		}
-	}
+		: Node(location), m_expr(expr) {}
 
 	void addCase(Node* label, Node* block) {
-		m_cases.push_back(std::pair<Node*, Node*>(label, block));
-		clever_addref(label);
-		clever_addref(block);
+		m_cases.push_back(NodePair(label, block));
 	}
 
-	std::vector<std::pair<Node*, Node*> >& getCases() { return m_cases; }
+	NodePairList& getCases() { return m_cases; }
 
 	Node* getExpr() const { return m_expr; }
 
@@ -1410,7 +1123,7 @@ public:
 	virtual Node* accept(Transformer& transformer);
 private:
 	Node* m_expr;
-	std::vector<std::pair<Node*, Node*> > m_cases;
+	NodePairList m_cases;
 };
 
 }} // clever::ast
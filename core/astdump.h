@@ -177,8 +177,8 @@ public:
 
 		m_ws = std::string(++m_level, ' ');
 
-		std::vector<Node*> nodes = node->getNodes();
-		std::vector<Node*>::const_iterator it = nodes.begin(), end = nodes.end();
+		const NodeList& nodes = node->getNodes();
+		NodeList::const_iterator it = nodes.begin(), end = nodes.end();
 		while (it != end) {
 			(*it)->accept(*this);
 			++it;
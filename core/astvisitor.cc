@@ -11,8 +11,8 @@ namespace clever { namespace ast {
 
 void Visitor::visit(NodeArray* node)
 {
-	std::vector<Node*> nodes = node->getNodes();
-	std::vector<Node*>::const_iterator it = nodes.begin(), end = nodes.end();
+	const NodeList& nodes = node->getNodes();
+	NodeList::const_iterator it = nodes.begin(), end = nodes.end();
 	while (it != end) {
 		(*it)->accept(*this);
 		++it;
@@ -123,8 +123,8 @@ void Visitor::visit(ForEach* node)
 
 void Visitor::visit(If* node)
 {
-	std::vector<std::pair<Node*, Node*> > cond = node->getConditionals();
-	std::vector<std::pair<Node*, Node*> >::iterator cur(cond.begin()), end(cond.end());
+	const NodePairList& cond = node->getConditionals();
+	NodePairList::const_iterator cur(cond.begin()), end(cond.end());
 
 	while (cur != end) {
 		(*cur).first->accept(*this);
@@ -242,8 +242,8 @@ void Visitor::visit(Switch* node)
 {
 	node->getExpr()->accept(*this);
 
-	std::vector<std::pair<Node*, Node*> >& vec = node->getCases();
-	std::vector<std::pair<Node*, Node*> >::const_iterator it(vec.begin()),
+	NodePairList& vec = node->getCases();
+	NodePairList::const_iterator it(vec.begin()),
 		end(vec.end());
 
 	for (; it != end; ++it) {
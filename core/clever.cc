@@ -15,7 +15,7 @@
 
 namespace clever {
 
-jmp_buf fatal_error;
+THREAD_TLS jmp_buf fatal_error;
 
 /**
  * Errors and stuff.
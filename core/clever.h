@@ -23,7 +23,8 @@ class Type;
 class Value;
 class VM;
 
-extern jmp_buf fatal_error;
+/// Where fatal errors jump to, set by the code running the VM on each thread
+extern THREAD_TLS jmp_buf fatal_error;
 
 
 struct Clever {
@@ -9,6 +9,8 @@
 #include "core/codegen.h"
 #include "core/irbuilder.h"
 #include "modules/std/core/function.h"
+#include "modules/std/core/array.h"
+#include "modules/std/core/map.h"
 
 namespace clever { namespace ast {
 
@@ -84,11 +86,11 @@ void Codegen::visit(Block* node)
 
 void Codegen::visit(CriticalBlock* node)
 {
-	m_builder->push(OP_LOCK);
+	m_builder->push(OP_LOCK).loc = node->getLocation();
 
 	node->getBlock()->accept(*this);
 
-	m_builder->push(OP_UNLOCK);
+	m_builder->push(OP_UNLOCK).loc = node->getLocation();
 }
 
 void Codegen::visit(VariableDecl* node)
@@ -186,6 +188,9 @@ void Codegen::visit(FunctionDecl* node)
 	}
 
 	IR& start_func = m_builder->push(OP_JMP, Operand(JMP_ADDR, 0));
+	// The jump over the body, right before the function address, carries the
+	// declaration location
+	start_func.loc = node->getLocation();
 	Symbol* sym = NULL;
 	Function* func;
 
@@ -240,6 +245,7 @@ void Codegen::visit(Return* node)
 	} else {
 		m_builder->push(OP_RET);
 	}
+	m_builder->getLast().loc = node->getLocation();
 }
 
 void Codegen::visit(For* node)
@@ -280,6 +286,7 @@ void Codegen::visit(For* node)
 	}
 
 	m_builder->push(OP_JMP, Operand(JMP_ADDR, start_cond));
+	m_builder->getLast().loc = node->getLocation();
 
 	if (condition) {
 		jmpz->op2 = Operand(JMP_ADDR, m_builder->getSize());
@@ -346,6 +353,7 @@ void Codegen::visit(ForEach* node)
 	assign_next.op2 = mcall_next.result;
 
 	m_builder->push(OP_JMP, Operand(JMP_ADDR, start_cond));
+	m_builder->getLast().loc = node->getLocation();
 
 	jmpz.op2 = Operand(JMP_ADDR, m_builder->getSize());
 }
@@ -402,6 +410,7 @@ void Codegen::visit(While* node)
 	m_brks.pop();
 
 	m_builder->push(OP_JMP, Operand(JMP_ADDR, start_while));
+	m_builder->getLast().loc = node->getLocation();
 
 	jmpz.op2 = Operand(JMP_ADDR, m_builder->getSize());
 }
@@ -586,8 +595,8 @@ void Codegen::visit(Boolean* node)
 void Codegen::visit(If* node)
 {
 
-	std::vector<std::pair<Node*, Node*> >& branches = node->getConditionals();
-	std::vector<std::pair<Node*, Node*> >::const_iterator it(branches.begin()),
+	NodePairList& branches = node->getConditionals();
+	NodePairList::const_iterator it(branches.begin()),
 		end(branches.end());
 
 	m_jmps.push(AddrVector());
@@ -622,8 +631,59 @@ void Codegen::visit(If* node)
 	m_jmps.pop();
 }
 
+// Builds an Array/Map literal made only of constant elements once, in the
+// constant pool, leaving to the VM just the creation of a copy-on-write
+// reference to it
+bool Codegen::hoistLiteral(Instantiation* node)
+{
+	if (!node->hasArgs()) {
+		return false;
+	}
+
+	const Symbol* sym = node->getType()->getSymbol();
+	const clever::Type* type = sym->scope->getValue(sym->voffset)->getType();
+
+	if (type != CLEVER_ARRAY_TYPE
+		&& (type != CLEVER_MAP_TYPE || node->numArgs() % 2)) {
+		return false;
+	}
+
+	NodeList& args = node->getArgs()->getNodes();
+
+	for (size_t i = 0, j = args.size(); i < j; ++i) {
+		if (!args[i]->isLiteral()) {
+			return false;
+		}
+	}
+
+	ValueVector values;
+
+	for (size_t i = 0, j = args.size(); i < j; ++i) {
+		args[i]->accept(*this);
+
+		values.push_back(m_builder->getConstEnv()->getValue(args[i]->getVOffset()));
+	}
+
+	TypeObject* obj = type == CLEVER_ARRAY_TYPE
+		? static_cast<TypeObject*>(new ArrayObject(values))
+		: static_cast<TypeObject*>(new MapObject(values));
+
+	IR& inst = m_builder->push(OP_NEW_LIT,
+		Operand(FETCH_CONST, m_builder->getLiteral(type, obj)));
+
+	setTempResult(node, inst.result);
+
+	inst.loc = node->getLocation();
+
+	return true;
+}
+
 void Codegen::visit(Instantiation* node)
 {
+	if (hoistLiteral(node)) {
+		return;
+	}
+
 	if (node->hasArgs()) {
 		sendArgs(node->getArgs());
 	}
@@ -748,8 +808,8 @@ void Codegen::visit(Switch* node)
 {
 	node->getExpr()->accept(*this);
 
-	std::vector<std::pair<Node*, Node*> >& cases = node->getCases();
-	std::vector<std::pair<Node*, Node*> >::const_iterator it(cases.begin()),
+	NodePairList& cases = node->getCases();
+	NodePairList::const_iterator it(cases.begin()),
 		end(cases.end());
 
 	size_t default_addr = 0, ncases = cases.size();
@@ -39,6 +39,8 @@ public:
 
 	void sendArgs(NodeArray*);
 
+	bool hoistLiteral(Instantiation*);
+
 	void visit(Block*);
 	void visit(CriticalBlock*);
 	void visit(VariableDecl*);
@@ -12,6 +12,7 @@
 #include "core/codegen.h"
 #include "core/evaluator.h"
 #include "core/resolver.h"
+#include "core/timings.h"
 
 namespace clever {
 
@@ -22,7 +23,7 @@ void Compiler::init(const CString* fname)
 		return;
 	}
 
-	m_pkg.init();
+	preload();
 
 	if (fname) {
 		std::string path(*fname);
@@ -35,14 +36,52 @@ void Compiler::init(const CString* fname)
 	m_flags |= INITIALIZED;
 }
 
+/// Registers the packages, which can be done before knowing the script
+void Compiler::preload()
+{
+	if (m_flags & PRELOADED) {
+		return;
+	}
+
+	TimingScope timing("module registration");
+
+	m_pkg.init();
+
+	m_flags |= PRELOADED;
+}
+
+/// Creates and initializes a module and its submodules, which is otherwise
+/// done when they are imported, returns false if there is no such module
+bool Compiler::preloadModule(const std::string& name)
+{
+	preload();
+
+	// The other modules use the native types, which std.core creates, so it
+	// comes first as in every script
+	m_pkg.preloadModule(m_pkg.findModule("std.core"));
+
+	Module* module = m_pkg.findModule(name);
+
+	if (!module) {
+		return false;
+	}
+
+	m_pkg.preloadModule(module);
+
+	return true;
+}
+
 /// Frees all resource used by the compiler
 void Compiler::shutdown()
 {
+	delete m_resolver;
 	delete m_builder;
 
+	freeAST();
+
 	m_pkg.shutdown();
 
-	clever_delete_var(g_cstring_tbl);
+	Isolate::getCurrent()->shutdown();
 }
 
 /// Displays an error message and exits
@@ -84,9 +123,12 @@ void Compiler::genCode()
 		return;
 	}
 
+	ArenaScope arena(&m_arena);
 	ast::Node* tree = m_tree;
 
 	if (m_flags & USE_OPTIMIZER) {
+		TimingScope timing("evaluator");
+
 		ast::Evaluator evaluator;
 		tree = m_tree->accept(evaluator);
 	}
@@ -96,13 +138,26 @@ void Compiler::genCode()
 		tree->accept(astdump);
 	}
 
-	ast::Resolver resolver(m_pkg, getNamespace());
-	tree->accept(resolver);
+	if (m_builder && (m_flags & INTERACTIVE)) {
+		genLine(tree);
+		return;
+	}
+
+	TimingScope resolver_timing("resolver");
+
+	delete m_resolver;
+
+	m_resolver = new ast::Resolver(m_pkg, getNamespace());
+	tree->accept(*m_resolver);
+
+	resolver_timing.stop();
 
 	if (!(m_flags & PARSER_ONLY)) {
-		m_global_env = resolver.getGlobalEnv();
+		m_global_env = m_resolver->getGlobalEnv();
+
+		TimingScope codegen_timing("codegen");
 
-		m_builder = new IRBuilder(m_global_env, resolver.getSymTable());
+		m_builder = new IRBuilder(m_global_env, m_resolver->getSymTable());
 
 		ast::Codegen codegen(m_builder);
 		tree->accept(codegen);
@@ -110,7 +165,41 @@ void Compiler::genCode()
 		m_builder->push(OP_HALT);
 	}
 
-	clever_delete_var(tree);
+	freeAST();
+}
+
+/// Generates the code of a line of an interactive session, resolved in the
+/// global scope of the previous lines and appended to their code
+void Compiler::genLine(ast::Node* tree)
+{
+	TimingScope resolver_timing("resolver");
+
+	m_resolver->resume(static_cast<ast::Block*>(tree));
+
+	resolver_timing.stop();
+
+	TimingScope codegen_timing("codegen");
+
+	// A failed line may have been left inside of a function
+	m_builder->setTempEnv(m_global_env->getTempEnv());
+
+	m_entry = m_builder->getSize();
+
+	ast::Codegen codegen(m_builder);
+	tree->accept(codegen);
+
+	m_builder->push(OP_HALT);
+
+	codegen_timing.stop();
+
+	freeAST();
+}
+
+/// Frees the AST trees all at once, the ones of the imported files included
+void Compiler::freeAST()
+{
+	m_tree = NULL;
+	m_arena.release();
 }
 
 } // clever
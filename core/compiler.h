@@ -16,10 +16,17 @@
 #include <vector>
 #include <stack>
 #include <sstream>
+#include "core/arena.h"
 #include "core/modmanager.h"
 #include "core/codegen.h"
 #include "core/irbuilder.h"
 
+namespace clever { namespace ast {
+
+class Resolver;
+
+}} // clever::ast
+
 namespace clever {
 
 class Driver;
@@ -34,15 +41,19 @@ public:
 		DUMP_AST       = 1 << 1,
 		USE_OPTIMIZER  = 1 << 2,
 		PARSER_ONLY    = 1 << 3,
-		INTERACTIVE    = 1 << 4
+		INTERACTIVE    = 1 << 4,
+		PRELOADED      = 1 << 5
 	};
 
 	Compiler(Driver* driver)
-		: m_tree(NULL), m_pkg(driver), m_builder(NULL), m_global_env(NULL), m_flags(0) {}
+		: m_tree(NULL), m_pkg(driver), m_resolver(NULL), m_builder(NULL),
+			m_global_env(NULL), m_entry(0), m_flags(0) {}
 
 	~Compiler() {}
 
 	void init(const CString*);
+	void preload();
+	bool preloadModule(const std::string&);
 	void shutdown();
 
 	void setFlags(size_t flags) { m_flags |= flags; }
@@ -50,12 +61,21 @@ public:
 	void setAST(ast::Node* tree) { m_tree = tree; }
 	ast::Node* getAST() { return m_tree; }
 
+	/// Arena the syntax trees are allocated from, to be entered while
+	/// parsing, which is freed once their code is generated
+	Arena& getArena() { return m_arena; }
+
 	void genCode();
 	const IRVector& getIR() { return m_builder->getIR(); }
 
+	/// Index of the first instruction generated by the last genCode(), the
+	/// code of the previous lines coming first in the interactive mode
+	size_t getEntry() const { return m_entry; }
+
 	Environment* getGlobalEnv() const { return m_global_env; }
 	Environment* getConstEnv() const { return m_builder->getConstEnv(); }
 	Environment* getTempEnv() const { return m_builder->getTempEnv(); }
+	Scope* getGlobalScope() const { return m_builder->getGlobalScope(); }
 
 	void setNamespace(const std::string& ns_name) { m_ns_name = ns_name; }
 	const std::string& getNamespace() const { return m_ns_name; }
@@ -65,18 +85,30 @@ public:
 	static void errorf(const location&, const char*, ...) CLEVER_NO_RETURN;
 
 private:
+	void genLine(ast::Node*);
+	void freeAST();
+
 	// AST tree
 	ast::Node* m_tree;
 
+	// Memory of the AST trees of the script and of the files it imports
+	Arena m_arena;
+
 	// Module manager
 	ModManager m_pkg;
 
+	// Symbol resolution, kept between the lines in the interactive mode
+	ast::Resolver* m_resolver;
+
 	// Vector of instructions to be passed to VM
 	IRBuilder* m_builder;
 
 	// Compiler pools, which got passed to VM after compiling
 	Environment* m_global_env;
 
+	// Start of the code generated last
+	size_t m_entry;
+
 	// Compiler flag
 	size_t m_flags;
 
@@ -1,14 +0,0 @@
-/**
- * Clever programming language
- * Copyright (c) Clever Team
- *
- * This file is distributed under the MIT license. See LICENSE for details.
- */
-
-#include "core/cstring.h"
-
-namespace clever {
-
-CStringTable* g_cstring_tbl = new CStringTable;
-
-} // clever
@@ -14,6 +14,7 @@
 #include <tr1/unordered_map>
 #endif
 #include "core/clever.h"
+#include "core/isolate.h"
 #include "core/refcounted.h"
 #include <iostream>
 
@@ -97,13 +98,11 @@ private:
 	DISALLOW_COPY_AND_ASSIGN(CStringTable);
 };
 
-extern CStringTable* g_cstring_tbl;
-
 /**
- * Returns the CString* pointer to a string
+ * Returns the CString* pointer to a string, interned in the current isolate
  */
 inline const CString* CSTRING(const std::string& str) {
-	return g_cstring_tbl->intern(str);
+	return Isolate::getCurrent()->getStringTable()->intern(str);
 }
 
 /**
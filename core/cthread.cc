@@ -31,10 +31,30 @@ bool CCondition::broadcast()
 
 bool CCondition::wait(CMutex& m)
 {
-	return pthread_cond_wait(&condition, &m.m_mut) == 0;
+	LockStats::Site* site = m.m_site;
+
+	if (EXPECTED(site == NULL)) {
+		return pthread_cond_wait(&condition, &m.m_mut) == 0;
+	}
+
+	// The lock is released while waiting, so the hold time is split in two
+	LockStats::nsecs_t start = LockStats::now();
+
+	LockStats::released(site, start - m.m_acquired);
+	m.m_site = NULL;
+
+	bool ret = pthread_cond_wait(&condition, &m.m_mut) == 0;
+
+	m.m_acquired = LockStats::now();
+	m.m_site = site;
+
+	LockStats::waited(site, m.m_acquired - start);
+
+	return ret;
 }
 
 CMutex::CMutex()
+	: m_name(NULL), m_site(NULL), m_acquired(0)
 {
 #ifdef CLEVER_THREADS
 # ifndef CLEVER_WIN32
@@ -60,6 +80,9 @@ bool CMutex::lock()
 {
 #ifdef CLEVER_THREADS
 # ifndef CLEVER_WIN32
+	if (UNEXPECTED(m_name && LockStats::isEnabled())) {
+		return lockProfiled();
+	}
 	return pthread_mutex_lock(&m_mut) == 0;
 # else
 	WaitForSingleObject(m_mut, INFINITE);
@@ -67,15 +90,48 @@ bool CMutex::lock()
 #endif
 }
 
+// Acquires the lock recording whether it had to wait and for how long
+bool CMutex::lockProfiled()
+{
+	LockStats::nsecs_t wait = 0;
+	bool contended = pthread_mutex_trylock(&m_mut) != 0;
+
+	if (contended) {
+		LockStats::nsecs_t start = LockStats::now();
+
+		if (pthread_mutex_lock(&m_mut) != 0) {
+			return false;
+		}
+		wait = LockStats::now() - start;
+	}
+
+	m_site = LockStats::acquired(m_name, contended, wait);
+	m_acquired = LockStats::now();
+
+	return true;
+}
+
 bool CMutex::trylock()
 {
-	return pthread_mutex_trylock(&m_mut) == 0;
+	if (pthread_mutex_trylock(&m_mut) != 0) {
+		return false;
+	}
+
+	if (UNEXPECTED(m_name && LockStats::isEnabled())) {
+		m_site = LockStats::acquired(m_name, false, 0);
+		m_acquired = LockStats::now();
+	}
+	return true;
 }
 
 bool CMutex::unlock()
 {
 #ifdef CLEVER_THREADS
 # ifndef CLEVER_WIN32
+	if (UNEXPECTED(m_site != NULL)) {
+		LockStats::released(m_site, LockStats::now() - m_acquired);
+		m_site = NULL;
+	}
 	return pthread_mutex_unlock(&m_mut) == 0;
 # else
 	ReleaseMutex(m_mut);
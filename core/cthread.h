@@ -13,7 +13,9 @@
 #else
 # include <win32/win32.h>
 #endif
+#include <string>
 #include "core/clever.h"
+#include "core/lockstats.h"
 
 namespace clever {
 
@@ -27,6 +29,8 @@ public:
 	bool unlock();
 	bool trylock();
 
+	/// Names the lock in the contention profile, only named locks are profiled
+	void setName(const std::string& name) { m_name = LockStats::intern(name); }
 
 #ifndef CLEVER_WIN32
 	pthread_mutex_t m_mut;
@@ -35,6 +39,16 @@ public:
 #endif
 
 private:
+	bool lockProfiled();
+
+	const std::string* m_name;
+
+	// Where and when the owner acquired the lock, while profiled
+	LockStats::Site* m_site;
+	LockStats::nsecs_t m_acquired;
+
+	friend class CCondition;
+
 	DISALLOW_COPY_AND_ASSIGN(CMutex);
 };
 
@@ -13,6 +13,7 @@
 #include "core/position.hh"
 #include "core/vm.h"
 #include "core/scanner.h"
+#include "core/timings.h"
 
 namespace clever {
 
@@ -20,6 +21,7 @@ int* g_clever_argc;
 char*** g_clever_argv;
 
 Interpreter::Interpreter(int* argc, char*** argv)
+	: m_vm(NULL)
 {
 	g_clever_argc = argc;
 	g_clever_argv = argv;
@@ -38,23 +40,69 @@ void Interpreter::execute(bool interactive)
 	if (status == 0) {
 		m_compiler.genCode();
 
+		if (interactive) {
+			executeLine();
+			return;
+		}
+
+		TimingScope vm_timing("vm setup");
+
 		VM vm(m_compiler.getIR());
 
 		vm.setConstEnv(m_compiler.getConstEnv());
 		vm.setGlobalEnv(m_compiler.getGlobalEnv());
 
+		vm_timing.stop();
+
 #ifdef CLEVER_DEBUG
 		if (m_dump_opcode) {
 			vm.dumpOpcodes();
 		}
 #endif
+		TimingScope run_timing("execution");
+
 		vm.run();
+	} else {
+		// The VM is gone without running its destructor
+		VM::setCurrent(NULL);
+		Timings::endAll();
+	}
+}
+
+/// Runs the code of the last line of an interactive session, on the VM
+/// kept between the lines along with the globals and the objects they hold
+void Interpreter::executeLine()
+{
+	if (!m_vm) {
+		m_vm = new VM;
+
+		m_vm->setConstEnv(m_compiler.getConstEnv());
+		m_vm->setGlobalEnv(m_compiler.getGlobalEnv());
+		m_vm->keepObjects();
+	}
+
+	m_vm->extend(m_compiler.getIR());
+	m_vm->resetState();
+	m_vm->setPC(m_compiler.getEntry());
+
+#ifdef CLEVER_DEBUG
+	if (m_dump_opcode) {
+		m_vm->dumpOpcodes();
 	}
+#endif
+	TimingScope run_timing("execution");
+
+	m_vm->run();
 }
 
 /// Frees the resource used to load and execute the script
 void Interpreter::shutdown()
 {
+	TimingScope timing("shutdown");
+
+	delete m_vm;
+	m_vm = NULL;
+
 	m_compiler.shutdown();
 }
 
@@ -86,6 +134,9 @@ int Driver::loadFile(const std::string& filename, const std::string& ns_name)
 	m_compiler.setFlags(m_cflags);
 	m_compiler.setNamespace(ns_name);
 
+	TimingScope timing("load", filename);
+
+	ArenaScope arena(&m_compiler.getArena());
 	ScannerState* new_scanner = new ScannerState;
 	Parser parser(*this, *new_scanner, m_compiler);
 	std::string& source = new_scanner->getSource();
@@ -105,8 +156,12 @@ int Driver::loadFile(const std::string& filename, const std::string& ns_name)
 	// Bison debug option
 	parser.set_debug_level(m_trace_parsing);
 
+	TimingScope parse_timing("parse");
+
 	int result = parser.parse();
 
+	parse_timing.stop();
+
 	delete new_scanner;
 	m_scanners.pop();
 
@@ -123,6 +178,7 @@ int Driver::loadStr(const std::string& code, bool importStd)
 {
 	m_compiler.setFlags(m_cflags);
 
+	ArenaScope arena(&m_compiler.getArena());
 	ScannerState *new_scanner = new ScannerState;
 	Parser parser(*this, *new_scanner, m_compiler);
 	std::string& source = new_scanner->getSource();
@@ -142,8 +198,12 @@ int Driver::loadStr(const std::string& code, bool importStd)
 	// Bison debug option
 	parser.set_debug_level(m_trace_parsing);
 
+	TimingScope timing("parse", "<command line>");
+
 	int result = parser.parse();
 
+	timing.stop();
+
 	delete new_scanner;
 	m_scanners.pop();
 
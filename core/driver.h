@@ -24,6 +24,7 @@ extern int* g_clever_argc;
 extern char*** g_clever_argv;
 
 class ScannerState;
+class VM;
 
 // Lexer prototype
 Parser::token_type yylex(Parser::semantic_type*,
@@ -114,6 +115,11 @@ public:
 	void execute(bool interactive);
 	void shutdown();
 private:
+	void executeLine();
+
+	// VM running the lines of an interactive session
+	VM* m_vm;
+
 	DISALLOW_COPY_AND_ASSIGN(Interpreter);
 };
 
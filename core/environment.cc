@@ -10,6 +10,28 @@
 
 namespace clever {
 
+Environment::~Environment()
+{
+	MemStats::free(MemStats::ENVIRONMENT, m_counted);
+
+	clever_delref(m_outer);
+
+	if (!m_scoped) {
+		clever_delref(m_temp);
+	}
+
+	if (m_values) {
+		// The slots are destroyed with the block, none may still be shared
+		for (size_t i = 0; i < m_num_values; ++i) {
+			clever_assert(m_values[i].refCount() == 1,
+				"Inline value escaped from its environment, use Value::clone().");
+		}
+		delete[] m_values;
+	} else {
+		std::for_each(m_data.begin(), m_data.end(), clever_delref);
+	}
+}
+
 Environment* Environment::clone()
 {
 	Environment* env = new Environment(m_outer, m_scoped);
@@ -20,38 +42,43 @@ Environment* Environment::clone()
 	if (m_temp)
 		env->m_temp = m_temp->clone();
 
-	env->m_data.reserve(m_data.size());
+	env->m_data.reserve(getSize());
 
-	for (size_t i = 0, size = m_data.size(); i < size; ++i)
-		env->pushValue(m_data[i]->clone());
+	for (size_t i = 0, size = getSize(); i < size; ++i)
+		env->pushValue(getLocal(i)->clone());
 
 	return env;
 }
 
 Environment* Environment::activate(Environment* outer)
 {
-	Environment* env = clone();
+	Environment* env = new Environment(outer ? outer : m_outer, false);
+	size_t size = getSize();
+
+	env->m_ret_val = m_ret_val;
+	env->m_ret_addr = m_ret_addr;
 
-	if (outer) {
-		clever_delref(env->m_outer);
-		env->m_outer = outer;
-		clever_addref(env->m_outer);
+	if (m_temp) {
+		env->m_temp = m_temp->clone();
 	}
 
-	env->m_scoped = false;
+	if (size) {
+		env->m_values = new Value[size];
+		env->m_num_values = size;
+
+		for (size_t i = 0; i < size; ++i) {
+			const Value* value = getLocal(i);
+
+			env->m_values[i].copy(value);
+			env->m_values[i].setConst(value->isConst());
+		}
+	}
 
 	return env;
 }
 
-Value* Environment::getValue(const ValueOffset& offset) const
+Value* Environment::getOuterValue(const ValueOffset& offset) const
 {
-	if (offset.first == 0) { // local
-		clever_assert(offset.second < m_data.size(),
-				"`offset.second` must be within `m_data` limits.");
-
-		return m_data[offset.second];
-	}
-
 	size_t depth = offset.first;
 	Environment* env = m_outer;
 
@@ -61,11 +88,11 @@ Value* Environment::getValue(const ValueOffset& offset) const
 
 	clever_assert(depth == 0,
 			"`depth` must be zero, otherwise we failed to find the environment.");
-	clever_assert(offset.second < env->m_data.size(),
-			"`offset.second` must be within `m_data` bounds.");
 	clever_assert_not_null(env);
+	clever_assert(offset.second < env->getSize(),
+			"`offset.second` must be within the environment bounds.");
 
-	return env->m_data[offset.second];
+	return env->getLocal(offset.second);
 }
 
 } // clever
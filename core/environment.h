@@ -11,10 +11,11 @@
 #include <algorithm>
 #include <vector>
 #include "core/refcounted.h"
+#include "core/memstats.h"
+#include "core/value.h"
 
 namespace clever {
 
-class Value;
 class Environment;
 
 /// @brief a pair specifying how many environments to `escape` and what value to fetch.
@@ -34,28 +35,31 @@ typedef std::pair<size_t, size_t> ValueOffset;
  * The later takes those environments and *activate* them upon user function
  * call or thread creation.
  *
+ * Activated environments keep their values inline, in a single contiguous
+ * block, instead of one heap allocated Value per slot. The block is never
+ * resized, so pointers returned by getValue() stay valid for the lifetime of
+ * the environment (e.g. while a closure holds it as its outer environment).
+ * Code that needs a value to outlive its environment must keep a clone() of
+ * it rather than a reference. Temporary environments are the exception: the
+ * VM rebinds their slots to values owned by other objects, so they keep one
+ * Value per slot.
+ *
  */
 class Environment: public RefCounted {
 public:
 	Environment()
-		: m_outer(NULL), m_temp(NULL), m_ret_val(NULL),
-		m_ret_addr(0), m_scoped(true) {}
+		: m_outer(NULL), m_temp(NULL), m_values(NULL), m_num_values(0),
+		m_ret_val(NULL), m_ret_addr(0), m_scoped(true),
+		m_counted(MemStats::alloc(MemStats::ENVIRONMENT)) {}
 
 	explicit Environment(Environment* outer_, bool is_scoped = true)
-		: m_outer(outer_), m_temp(NULL), m_ret_val(NULL),
-		m_ret_addr(0), m_scoped(is_scoped) {
+		: m_outer(outer_), m_temp(NULL), m_values(NULL), m_num_values(0),
+		m_ret_val(NULL), m_ret_addr(0), m_scoped(is_scoped),
+		m_counted(MemStats::alloc(MemStats::ENVIRONMENT)) {
 		clever_addref(m_outer);
 	}
 
-	~Environment() {
-		clever_delref(m_outer);
-
-		if (!m_scoped) {
-			clever_delref(m_temp);
-		}
-
-		std::for_each(m_data.begin(), m_data.end(), clever_delref);
-	}
+	~Environment();
 
 	/**
 	 * @brief pushes a value into the environment.
@@ -63,6 +67,9 @@ public:
 	 * @return the index of the newly pushed value.
 	 */
 	ValueOffset pushValue(Value* value) {
+		clever_assert(m_values == NULL,
+			"Cannot push values into an activated environment.");
+
 		m_data.push_back(value);
 		return ValueOffset(0, m_data.size()-1);
 	}
@@ -76,7 +83,15 @@ public:
 	 * @param offset
 	 * @return
 	 */
-	Value* getValue(const ValueOffset&) const;
+	Value* getValue(const ValueOffset& offset) const {
+		if (EXPECTED(offset.first == 0)) { // local
+			clever_assert(offset.second < getSize(),
+				"`offset.second` must be within the environment limits.");
+
+			return getLocal(offset.second);
+		}
+		return getOuterValue(offset);
+	}
 
 	/**
 	 * @brief ativates the current environment.
@@ -103,21 +118,44 @@ public:
 		clever_addref(outer);
 	}
 
-	void setData(size_t pos, Value* value) { m_data[pos] = value; }
+	void setData(size_t pos, Value* value) {
+		clever_assert(m_values == NULL,
+			"Cannot rebind a slot of an activated environment.");
+
+		m_data[pos] = value;
+	}
 
 	void setTempEnv(Environment* env) { m_temp = env; }
 	Environment* getTempEnv() const { return m_temp; }
 
+	/// Number of value slots
+	size_t getSize() const {
+		return m_values ? m_num_values : m_data.size();
+	}
+
+	/// Whether the values are held inline, as in the copies made by activate()
+	bool hasInlineValues() const { return m_values != NULL; }
+
 private:
 	Environment* m_outer;
 	Environment* m_temp;
 	std::vector<Value*> m_data;
+	Value* m_values;
+	size_t m_num_values;
 	Value* m_ret_val;
 	size_t m_ret_addr;
 	bool m_scoped;
+	bool m_counted;
 
 	Environment* clone();
 
+	Value* getLocal(size_t pos) const {
+		return m_values ? m_values + pos : m_data[pos];
+	}
+
+	/// Looks up a value of an enclosing environment
+	Value* getOuterValue(const ValueOffset&) const;
+
 	DISALLOW_COPY_AND_ASSIGN(Environment);
 };
 
@@ -64,10 +64,7 @@ Node* Evaluator::transform(Arithmetic* node) {
 			case Arithmetic::MOP_MOD: val = lhs % rhs; break;
 		}
 
-		Node* tnode = new IntLit(val, node->getLocation());
-		node->delRef();
-
-		return tnode;
+		return new IntLit(val, node->getLocation());
 	}
 
 	return node;
@@ -0,0 +1,391 @@
+/**
+ * Clever programming language
+ * Copyright (c) Clever Team
+ *
+ * This file is distributed under the MIT license. See LICENSE for details.
+ */
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include "core/heapsnapshot.h"
+#include "core/vm.h"
+#include "core/value.h"
+#include "core/environment.h"
+#include "core/user.h"
+#include "modules/std/core/array.h"
+#include "modules/std/core/map.h"
+#include "modules/std/core/function.h"
+
+namespace clever {
+
+std::string HeapSnapshot::s_signal_path;
+volatile sig_atomic_t HeapSnapshot::s_pending = 0;
+
+// Number of fields per node and per edge in the serialized arrays
+static const size_t NODE_FIELDS = 6;
+static const size_t EDGE_FIELDS = 3;
+
+// Longest string content kept as a node name
+static const size_t MAX_NAME_LENGTH = 64;
+
+static void write_json_string(std::ostream& out, const std::string& str)
+{
+	out << '"';
+
+	for (size_t i = 0, j = str.size(); i < j; ++i) {
+		unsigned char c = str[i];
+
+		switch (c) {
+			case '"':  out << "\\\""; break;
+			case '\\': out << "\\\\"; break;
+			case '\n': out << "\\n";  break;
+			case '\r': out << "\\r";  break;
+			case '\t': out << "\\t";  break;
+			default:
+				if (c < 0x20) {
+					char buf[8];
+					snprintf(buf, sizeof(buf), "\\u%04x", c);
+					out << buf;
+				} else {
+					out << c;
+				}
+		}
+	}
+	out << '"';
+}
+
+size_t HeapSnapshot::getString(const std::string& str)
+{
+	StringMap::const_iterator it = m_string_ids.find(str);
+
+	if (it != m_string_ids.end()) {
+		return it->second;
+	}
+
+	m_strings.push_back(str);
+	m_string_ids.insert(StringMap::value_type(str, m_strings.size() - 1));
+
+	return m_strings.size() - 1;
+}
+
+size_t HeapSnapshot::addNode(NodeKind kind, NodeType type,
+	const std::string& name, size_t size)
+{
+	m_nodes.push_back(Node(kind, type, getString(name), size));
+
+	return m_nodes.size() - 1;
+}
+
+void HeapSnapshot::addEdge(size_t from, EdgeType type, const std::string& name, size_t to)
+{
+	m_nodes[from].edges.push_back(Edge(type, getString(name), to));
+}
+
+void HeapSnapshot::addElement(size_t from, size_t index, size_t to)
+{
+	m_nodes[from].edges.push_back(Edge(ELEMENT, index, to));
+}
+
+size_t HeapSnapshot::getNode(const Value* value)
+{
+	NodeMap::const_iterator it = m_node_ids.find(value);
+
+	if (it != m_node_ids.end()) {
+		return it->second;
+	}
+
+	size_t id = addNode(K_VALUE, NATIVE, "Value", sizeof(Value));
+
+	m_nodes[id].obj = value;
+	m_node_ids.insert(NodeMap::value_type(value, id));
+
+	return id;
+}
+
+size_t HeapSnapshot::getNode(const Environment* env)
+{
+	NodeMap::const_iterator it = m_node_ids.find(env);
+
+	if (it != m_node_ids.end()) {
+		return it->second;
+	}
+
+	// Activated environments hold their values in a block of their own
+	size_t size = sizeof(Environment) + env->getSize() *
+		(env->hasInlineValues() ? sizeof(Value) : sizeof(Value*));
+	size_t id = addNode(K_ENVIRONMENT, NATIVE, "Environment", size);
+
+	m_nodes[id].obj = env;
+	m_node_ids.insert(NodeMap::value_type(env, id));
+
+	return id;
+}
+
+size_t HeapSnapshot::getNode(const TypeObject* obj, const Type* type)
+{
+	NodeMap::const_iterator it = m_node_ids.find(obj);
+
+	if (it != m_node_ids.end()) {
+		return it->second;
+	}
+
+	NodeType node_type = OBJECT;
+	std::string name = type->getName();
+	size_t size = MemStats::getObjectSize(type, obj);
+
+	if (type == CLEVER_STR_TYPE) {
+		node_type = STRING;
+		name = static_cast<const StrObject*>(obj)->value->substr(0, MAX_NAME_LENGTH);
+	} else if (type == CLEVER_INT_TYPE || type == CLEVER_DOUBLE_TYPE
+		|| type == CLEVER_BOOL_TYPE) {
+		node_type = NUMBER;
+		name = type->toString(const_cast<TypeObject*>(obj));
+	} else if (type == CLEVER_FUNC_TYPE) {
+		node_type = CLOSURE;
+		name = static_cast<const Function*>(obj)->getName();
+	}
+
+	size_t id = addNode(K_OBJECT, node_type, name, size);
+
+	m_nodes[id].obj = obj;
+	m_nodes[id].obj_type = type;
+	m_node_ids.insert(NodeMap::value_type(obj, id));
+
+	return id;
+}
+
+/// Adds the edges leaving the node, creating the nodes they point to
+void HeapSnapshot::visit(size_t id)
+{
+	const NodeKind kind = m_nodes[id].kind;
+	const void* ptr = m_nodes[id].obj;
+
+	if (kind == K_VALUE) {
+		const Value* value = static_cast<const Value*>(ptr);
+
+		if (value->getObj() && value->getType()) {
+			addEdge(id, INTERNAL, "data", getNode(value->getObj(), value->getType()));
+		}
+	} else if (kind == K_ENVIRONMENT) {
+		const Environment* env = static_cast<const Environment*>(ptr);
+
+		for (size_t i = 0, j = env->getSize(); i < j; ++i) {
+			const Value* value = env->getValue(ValueOffset(0, i));
+
+			if (value) {
+				addElement(id, i, getNode(value));
+			}
+		}
+
+		if (env->getOuter()) {
+			addEdge(id, CONTEXT, "outer", getNode(env->getOuter()));
+		}
+		if (env->getTempEnv()) {
+			addEdge(id, INTERNAL, "temporaries", getNode(env->getTempEnv()));
+		}
+		if (env->getRetVal()) {
+			addEdge(id, INTERNAL, "return value", getNode(env->getRetVal()));
+		}
+	} else if (kind == K_OBJECT) {
+		const TypeObject* obj = static_cast<const TypeObject*>(ptr);
+		const Type* type = m_nodes[id].obj_type;
+		const MemberMap& members = obj->getMembers();
+		MemberMap::const_iterator it(members.begin()), end(members.end());
+
+		for (; it != end; ++it) {
+			if (it->second.value) {
+				addEdge(id, PROPERTY, *it->first, getNode(it->second.value));
+			}
+		}
+
+		if (type == CLEVER_ARRAY_TYPE) {
+			const std::vector<Value*>& data = static_cast<const ArrayObject*>(obj)->getData();
+
+			for (size_t i = 0, j = data.size(); i < j; ++i) {
+				if (data[i]) {
+					addElement(id, i, getNode(data[i]));
+				}
+			}
+		} else if (type == CLEVER_MAP_TYPE) {
+			const std::map<std::string, Value*>& data =
+				static_cast<const MapObject*>(obj)->getData();
+			std::map<std::string, Value*>::const_iterator itm(data.begin()), endm(data.end());
+
+			for (; itm != endm; ++itm) {
+				if (itm->second) {
+					addEdge(id, PROPERTY, itm->first, getNode(itm->second));
+				}
+			}
+		} else if (type == CLEVER_FUNC_TYPE) {
+			const Function* func = static_cast<const Function*>(obj);
+
+			if (func->isUserDefined() && func->getEnvironment()) {
+				addEdge(id, CONTEXT, "environment", getNode(func->getEnvironment()));
+			}
+		} else if (type->isUserDefined()) {
+			const UserObject* uobj = static_cast<const UserObject*>(obj);
+
+			if (uobj->getEnvironment()) {
+				addEdge(id, INTERNAL, "environment", getNode(uobj->getEnvironment()));
+			}
+		}
+	}
+}
+
+/// Adds the roots and walks everything reachable from them
+void HeapSnapshot::build()
+{
+	size_t root = addNode(K_SYNTHETIC, SYNTHETIC, "", 0);
+
+	if (m_vm->m_const_env) {
+		addEdge(root, INTERNAL, "(constants)", getNode(m_vm->m_const_env));
+	}
+	if (m_vm->m_global_env) {
+		addEdge(root, INTERNAL, "(globals)", getNode(m_vm->m_global_env));
+	}
+
+	size_t stack = addNode(K_SYNTHETIC, SYNTHETIC, "(call stack)", 0);
+	CallStack frames(m_vm->m_call_stack);
+
+	addEdge(root, INTERNAL, "(call stack)", stack);
+
+	for (size_t i = 0; !frames.empty(); ++i) {
+		addElement(stack, i, getNode(frames.top().env));
+		frames.pop();
+	}
+
+	size_t store = addNode(K_SYNTHETIC, SYNTHETIC, "(object store)", 0);
+	std::stack<ObjectStore> objs(m_vm->m_obj_store);
+
+	addEdge(root, INTERNAL, "(object store)", store);
+
+	for (size_t i = 0; !objs.empty(); objs.pop()) {
+		const ObjectStore& envs = objs.top();
+
+		for (size_t k = 0, j = envs.size(); k < j; ++k) {
+			addElement(store, i++, getNode(envs[k].env));
+		}
+	}
+
+	// Nodes are appended while visiting, so this walks the whole graph
+	for (size_t i = 0; i < m_nodes.size(); ++i) {
+		visit(i);
+	}
+}
+
+void HeapSnapshot::write(std::ostream& out)
+{
+	static const char* node_types[] = { "hidden", "array", "string", "object",
+		"code", "closure", "regexp", "number", "native", "synthetic" };
+	static const char* edge_types[] = { "context", "element", "property", "internal" };
+
+	build();
+
+	size_t num_edges = 0;
+
+	for (size_t i = 0, j = m_nodes.size(); i < j; ++i) {
+		num_edges += m_nodes[i].edges.size();
+	}
+
+	out << "{\"snapshot\":{\"meta\":{"
+		"\"node_fields\":[\"type\",\"name\",\"id\",\"self_size\",\"edge_count\",\"trace_node_id\"],"
+		"\"node_types\":[[";
+
+	for (size_t i = 0; i < sizeof(node_types) / sizeof(node_types[0]); ++i) {
+		out << (i ? ",\"" : "\"") << node_types[i] << "\"";
+	}
+
+	out << "],\"string\",\"number\",\"number\",\"number\",\"number\"],"
+		"\"edge_fields\":[\"type\",\"name_or_index\",\"to_node\"],"
+		"\"edge_types\":[[";
+
+	for (size_t i = 0; i < sizeof(edge_types) / sizeof(edge_types[0]); ++i) {
+		out << (i ? ",\"" : "\"") << edge_types[i] << "\"";
+	}
+
+	out << "],\"string_or_number\",\"node\"]},"
+		<< "\"node_count\":" << m_nodes.size() << ","
+		<< "\"edge_count\":" << num_edges << "},\n\"nodes\":[";
+
+	for (size_t i = 0, j = m_nodes.size(); i < j; ++i) {
+		const Node& node = m_nodes[i];
+
+		out << (i ? ",\n" : "") << node.type << "," << node.name << ","
+			<< (i * 2 + 1) << "," << node.size << "," << node.edges.size() << ",0";
+	}
+
+	out << "],\n\"edges\":[";
+
+	bool first = true;
+
+	for (size_t i = 0, j = m_nodes.size(); i < j; ++i) {
+		const std::vector<Edge>& edges = m_nodes[i].edges;
+
+		for (size_t k = 0, l = edges.size(); k < l; ++k) {
+			out << (first ? "" : ",\n") << edges[k].type << "," << edges[k].name
+				<< "," << edges[k].to * NODE_FIELDS;
+			first = false;
+		}
+	}
+
+	out << "],\n\"strings\":[";
+
+	for (size_t i = 0, j = m_strings.size(); i < j; ++i) {
+		if (i) {
+			out << ",\n";
+		}
+		write_json_string(out, m_strings[i]);
+	}
+
+	out << "]}\n";
+}
+
+bool HeapSnapshot::write(const std::string& path)
+{
+	std::ofstream out(path.c_str());
+
+	if (!out) {
+		return false;
+	}
+
+	write(out);
+
+	return out.good();
+}
+
+void HeapSnapshot::onSignal(int)
+{
+	s_pending = 1;
+	VM::interrupt();
+}
+
+void HeapSnapshot::setSignalPath(const std::string& path)
+{
+	s_signal_path = path;
+
+#ifdef SIGUSR2
+	signal(SIGUSR2, HeapSnapshot::onSignal);
+#endif
+}
+
+/// Writes <prefix>.<n>.heapsnapshot for the n-th signal received
+void HeapSnapshot::writePending(const VM* vm)
+{
+	static size_t count = 0;
+	std::ostringstream path;
+
+	s_pending = 0;
+
+	path << s_signal_path << "." << ++count << ".heapsnapshot";
+
+	HeapSnapshot snapshot(vm);
+
+	if (snapshot.write(path.str())) {
+		std::cerr << "Heap snapshot written to " << path.str() << std::endl;
+	} else {
+		std::cerr << "Couldn't write heap snapshot to " << path.str() << std::endl;
+	}
+}
+
+} // clever
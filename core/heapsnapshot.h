@@ -0,0 +1,124 @@
+/**
+ * Clever programming language
+ * Copyright (c) Clever Team
+ *
+ * This file is distributed under the MIT license. See LICENSE for details.
+ */
+
+#ifndef CLEVER_HEAPSNAPSHOT_H
+#define CLEVER_HEAPSNAPSHOT_H
+
+#include <csignal>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+#include "core/clever.h"
+
+namespace clever {
+
+class VM;
+class Value;
+class Environment;
+class TypeObject;
+class Type;
+
+/**
+ * @brief dumps the graph of Values, objects and Environments reachable from
+ * a VM.
+ *
+ * The roots are the constant and global environments, the environments on
+ * the call stack and the object store; module variables are reached through
+ * the environments they were imported into. The output uses the JSON layout
+ * of the .heapsnapshot files, so it can be loaded by the heap viewers of the
+ * Chrome and Node.js developer tools. Sizes are shallow.
+ */
+class HeapSnapshot {
+public:
+	explicit HeapSnapshot(const VM* vm)
+		: m_vm(vm) {}
+
+	~HeapSnapshot() {}
+
+	/// Walks the heap and writes the snapshot to the file
+	bool write(const std::string& path);
+
+	/// Walks the heap and writes the snapshot to the stream
+	void write(std::ostream& out);
+
+	/// Arms SIGUSR2 to write a snapshot at the VM's next safe point
+	static void setSignalPath(const std::string& path);
+
+	/// Writes the snapshot requested by the signal handler, if any
+	static void handlePending(const VM* vm) {
+		if (UNEXPECTED(s_pending)) {
+			writePending(vm);
+		}
+	}
+private:
+	enum NodeType { HIDDEN, ARRAY, STRING, OBJECT, CODE, CLOSURE, REGEXP,
+		NUMBER, NATIVE, SYNTHETIC };
+
+	enum EdgeType { CONTEXT, ELEMENT, PROPERTY, INTERNAL };
+
+	struct Edge {
+		Edge(EdgeType type_, size_t name_, size_t to_)
+			: type(type_), name(name_), to(to_) {}
+
+		EdgeType type;
+		size_t name;
+		size_t to;
+	};
+
+	/// What a node stands for, to know how to walk its children
+	enum NodeKind { K_SYNTHETIC, K_VALUE, K_ENVIRONMENT, K_OBJECT };
+
+	struct Node {
+		Node(NodeKind kind_, NodeType type_, size_t name_, size_t size_)
+			: kind(kind_), type(type_), name(name_), size(size_),
+				obj(NULL), obj_type(NULL) {}
+
+		NodeKind kind;
+		NodeType type;
+		size_t name;
+		size_t size;
+		const void* obj;
+		const Type* obj_type;
+		std::vector<Edge> edges;
+	};
+
+	typedef std::map<const void*, size_t> NodeMap;
+	typedef std::map<std::string, size_t> StringMap;
+
+	static void onSignal(int);
+	static void writePending(const VM*);
+
+	void build();
+	void visit(size_t);
+
+	size_t addNode(NodeKind, NodeType, const std::string&, size_t);
+	size_t getString(const std::string&);
+
+	void addEdge(size_t, EdgeType, const std::string&, size_t);
+	void addElement(size_t, size_t, size_t);
+
+	size_t getNode(const Value*);
+	size_t getNode(const Environment*);
+	size_t getNode(const TypeObject*, const Type*);
+
+	const VM* m_vm;
+
+	std::vector<Node> m_nodes;
+	std::vector<std::string> m_strings;
+	StringMap m_string_ids;
+	NodeMap m_node_ids;
+
+	static std::string s_signal_path;
+	static volatile sig_atomic_t s_pending;
+
+	DISALLOW_COPY_AND_ASSIGN(HeapSnapshot);
+};
+
+} // clever
+
+#endif // CLEVER_HEAPSNAPSHOT_H
@@ -9,6 +9,7 @@
 #define CLEVER_IR_H
 
 #include <cstddef>
+#include <deque>
 #include "core/opcode.h"
 #include "core/environment.h"
 #include "core/location.hh"
@@ -61,6 +61,8 @@ public:
 
 	Environment* getConstEnv() const { return m_const_env; }
 
+	Scope* getGlobalScope() const { return m_global_scope; }
+
 	void setTempEnv(Environment* env) { m_temp_env = env; }
 	Environment* getTempEnv() const { return m_temp_env; }
 
@@ -89,6 +91,15 @@ public:
 		return m_const_env->pushValue(new Value(c, true));
 	}
 
+	/// @brief get a constant offset for a prebuilt array/map literal
+	ValueOffset getLiteral(const Type* type, TypeObject* obj) {
+		Value* val = new Value(type, true);
+
+		val->setObj(type, obj);
+
+		return m_const_env->pushValue(val);
+	}
+
 	/// @brief get a constant offset for the `null` value
 	ValueOffset getNull() const {
 		return ValueOffset(0, 0);
@@ -0,0 +1,41 @@
+/**
+ * Clever programming language
+ * Copyright (c) Clever Team
+ *
+ * This file is distributed under the MIT license. See LICENSE for details.
+ */
+
+#include "core/isolate.h"
+#include "core/cstring.h"
+
+namespace clever {
+
+static Isolate g_default_isolate;
+
+THREAD_TLS Isolate* Isolate::s_current = &g_default_isolate;
+
+Isolate::Isolate()
+	: m_strings(new CStringTable), m_types()
+{
+}
+
+Isolate::~Isolate()
+{
+	clever_delete_var(m_strings);
+}
+
+Isolate* Isolate::getDefault()
+{
+	return &g_default_isolate;
+}
+
+void Isolate::shutdown()
+{
+	// The types were freed with the modules
+	m_types = NativeTypes();
+
+	delete m_strings;
+	m_strings = new CStringTable;
+}
+
+} // clever
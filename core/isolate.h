@@ -0,0 +1,108 @@
+/**
+ * Clever programming language
+ * Copyright (c) Clever Team
+ *
+ * This file is distributed under the MIT license. See LICENSE for details.
+ */
+
+#ifndef CLEVER_ISOLATE_H
+#define CLEVER_ISOLATE_H
+
+#include "core/clever.h"
+
+namespace clever {
+
+class CStringTable;
+class Type;
+
+/// The native types, created by std.core in the isolate it is loaded in
+struct NativeTypes {
+	Type* int_type;
+	Type* double_type;
+	Type* str_type;
+	Type* func_type;
+	Type* bool_type;
+	Type* array_type;
+	Type* map_type;
+	Type* arrayiter_type;
+
+	NativeTypes()
+		: int_type(NULL), double_type(NULL), str_type(NULL), func_type(NULL),
+			bool_type(NULL), array_type(NULL), map_type(NULL),
+			arrayiter_type(NULL) {}
+};
+
+/**
+ * @brief an independent instance of the runtime.
+ *
+ * An isolate owns the interned strings and the native types, which are the
+ * runtime state shared by the compilers and VMs created while it is entered.
+ * Each thread has a current isolate, the default one unless another was
+ * entered, and the threads started by a script enter the isolate of their
+ * parent.
+ *
+ * Interpreters living in different isolates share nothing but the process
+ * wide statistics (metrics, profiler, memory stats), so they can run in
+ * parallel, one isolate per thread, without any locking:
+ *
+ *   clever::Isolate isolate;
+ *   clever::IsolateScope scope(&isolate);
+ *
+ *   clever::Interpreter interp(&argc, &argv);
+ *   ...
+ *   interp.shutdown();
+ *
+ * An isolate can only be entered by a thread at a time, apart from the
+ * threads started by its own scripts.
+ */
+class Isolate {
+public:
+	Isolate();
+
+	~Isolate();
+
+	/// Returns the isolate entered by the current thread
+	static Isolate* getCurrent() { return s_current; }
+	static void setCurrent(Isolate* isolate) { s_current = isolate; }
+
+	/// Returns the isolate of the threads that never entered another one
+	static Isolate* getDefault();
+
+	CStringTable* getStringTable() const { return m_strings; }
+
+	NativeTypes& getTypes() { return m_types; }
+
+	/// Frees the interned strings once the compilers of the isolate have
+	/// been shut down, leaving the isolate ready to be used again
+	void shutdown();
+private:
+	CStringTable* m_strings;
+
+	NativeTypes m_types;
+
+	/// Isolate entered by the current thread
+	static THREAD_TLS Isolate* s_current;
+
+	DISALLOW_COPY_AND_ASSIGN(Isolate);
+};
+
+/// Enters an isolate on the current thread for the lifetime of the scope
+class IsolateScope {
+public:
+	explicit IsolateScope(Isolate* isolate)
+		: m_prev(Isolate::getCurrent()) {
+		Isolate::setCurrent(isolate);
+	}
+
+	~IsolateScope() {
+		Isolate::setCurrent(m_prev);
+	}
+private:
+	Isolate* m_prev;
+
+	DISALLOW_COPY_AND_ASSIGN(IsolateScope);
+};
+
+} // clever
+
+#endif // CLEVER_ISOLATE_H
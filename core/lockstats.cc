@@ -0,0 +1,230 @@
+/**
+ * Clever programming language
+ * Copyright (c) Clever Team
+ *
+ * This file is distributed under the MIT license. See LICENSE for details.
+ */
+
+#include <algorithm>
+#include <ctime>
+#include <iomanip>
+#include <map>
+#include <set>
+#include <sstream>
+#include <vector>
+#include "core/lockstats.h"
+#include "core/cthread.h"
+#include "core/vm.h"
+
+namespace clever {
+
+bool LockStats::s_enabled = false;
+
+// (lock name, file name, line)
+typedef std::pair<const std::string*, std::pair<const std::string*, size_t> > SiteKey;
+typedef std::map<SiteKey, LockStats::Site> SiteMap;
+
+static SiteMap g_sites;
+static std::set<std::string> g_names;
+
+// Unnamed, thus never profiled itself
+static CMutex g_lockstats_mutex;
+
+static bool by_wait(const LockStats::Site* a, const LockStats::Site* b)
+{
+	if (a->wait != b->wait) {
+		return a->wait > b->wait;
+	}
+	return a->acquired > b->acquired;
+}
+
+static void dump_site(std::ostream& out, const LockStats::Site& site,
+	const std::string& name)
+{
+	out << std::fixed << std::setprecision(3)
+		<< std::setw(10) << site.acquired
+		<< std::setw(10) << site.contended
+		<< std::setw(10) << site.wait / 1e6
+		<< std::setw(10) << site.max_wait / 1e6
+		<< std::setw(10) << site.hold / 1e6
+		<< std::setw(10) << site.max_hold / 1e6
+		<< std::setw(10) << site.cond_wait / 1e6
+		<< "  " << name << "\n";
+}
+
+LockStats::nsecs_t LockStats::now()
+{
+#ifndef CLEVER_WIN32
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return nsecs_t(ts.tv_sec) * 1000000000ULL + ts.tv_nsec;
+#else
+	LARGE_INTEGER freq, count;
+
+	QueryPerformanceFrequency(&freq);
+	QueryPerformanceCounter(&count);
+
+	return nsecs_t(count.QuadPart) * 1000000000ULL / freq.QuadPart;
+#endif
+}
+
+void LockStats::start()
+{
+	g_lockstats_mutex.lock();
+
+	// Locks being held may point to the sites, so they are only reset
+	for (SiteMap::iterator it(g_sites.begin()), end(g_sites.end()); it != end; ++it) {
+		it->second = Site(it->second.lock, it->second.file, it->second.line);
+	}
+
+	s_enabled = true;
+	g_lockstats_mutex.unlock();
+}
+
+void LockStats::stop()
+{
+	s_enabled = false;
+}
+
+const std::string* LockStats::intern(const std::string& name)
+{
+	g_lockstats_mutex.lock();
+
+	const std::string* interned = &*g_names.insert(name).first;
+
+	g_lockstats_mutex.unlock();
+
+	return interned;
+}
+
+std::string LockStats::nameHere(const char* kind)
+{
+	const VM* vm = VM::getCurrent();
+	const location* loc = vm ? vm->getLocation() : NULL;
+	std::ostringstream name;
+
+	name << kind;
+
+	if (loc) {
+		name << " at " << (loc->begin.filename ? *loc->begin.filename : "<command line>")
+			<< ":" << loc->begin.line;
+	}
+	return name.str();
+}
+
+LockStats::Site* LockStats::acquired(const std::string* lock, bool contended,
+	nsecs_t wait)
+{
+	const VM* vm = VM::getCurrent();
+	const location* loc = vm ? vm->getLocation() : NULL;
+	const std::string* file = loc ? loc->begin.filename : NULL;
+	size_t line = loc ? loc->begin.line : 0;
+
+	g_lockstats_mutex.lock();
+
+	SiteMap::iterator it = g_sites.find(SiteKey(lock, std::make_pair(file, line)));
+
+	if (it == g_sites.end()) {
+		it = g_sites.insert(SiteMap::value_type(SiteKey(lock, std::make_pair(file, line)),
+			Site(*lock, file ? *file : (loc ? "<command line>" : "<internal>"), line))).first;
+	}
+
+	Site* site = &it->second;
+
+	++site->acquired;
+
+	if (contended) {
+		++site->contended;
+		site->wait += wait;
+		site->max_wait = std::max(site->max_wait, wait);
+	}
+
+	g_lockstats_mutex.unlock();
+
+	return site;
+}
+
+void LockStats::released(Site* site, nsecs_t hold)
+{
+	g_lockstats_mutex.lock();
+	site->hold += hold;
+	site->max_hold = std::max(site->max_hold, hold);
+	g_lockstats_mutex.unlock();
+}
+
+void LockStats::waited(Site* site, nsecs_t wait)
+{
+	g_lockstats_mutex.lock();
+	++site->cond_waits;
+	site->cond_wait += wait;
+	g_lockstats_mutex.unlock();
+}
+
+void LockStats::dump(std::ostream& out)
+{
+	std::map<std::string, Site> totals;
+	std::vector<const Site*> locks, sites;
+
+	g_lockstats_mutex.lock();
+
+	for (SiteMap::const_iterator it(g_sites.begin()), end(g_sites.end()); it != end; ++it) {
+		const Site& site = it->second;
+
+		if (site.acquired == 0) {
+			continue;
+		}
+
+		std::map<std::string, Site>::iterator total = totals.find(site.lock);
+
+		if (total == totals.end()) {
+			total = totals.insert(std::make_pair(site.lock, Site(site.lock, "", 0))).first;
+		}
+
+		total->second.acquired   += site.acquired;
+		total->second.contended  += site.contended;
+		total->second.cond_waits += site.cond_waits;
+		total->second.wait       += site.wait;
+		total->second.hold       += site.hold;
+		total->second.cond_wait  += site.cond_wait;
+		total->second.max_wait = std::max(total->second.max_wait, site.max_wait);
+		total->second.max_hold = std::max(total->second.max_hold, site.max_hold);
+
+		sites.push_back(&site);
+	}
+
+	for (std::map<std::string, Site>::const_iterator it(totals.begin()),
+		end(totals.end()); it != end; ++it) {
+		locks.push_back(&it->second);
+	}
+
+	std::stable_sort(locks.begin(), locks.end(), by_wait);
+	std::stable_sort(sites.begin(), sites.end(), by_wait);
+
+	out << "Lock contention\n"
+		<< std::right << std::setw(10) << "acquired" << std::setw(10) << "contended"
+		<< std::setw(10) << "wait ms" << std::setw(10) << "max ms"
+		<< std::setw(10) << "hold ms" << std::setw(10) << "max ms"
+		<< std::setw(10) << "cond ms" << "  lock / site\n";
+
+	for (size_t i = 0, j = locks.size(); i < j; ++i) {
+		dump_site(out, *locks[i], locks[i]->lock);
+
+		for (size_t k = 0, l = sites.size(); k < l; ++k) {
+			if (sites[k]->lock != locks[i]->lock) {
+				continue;
+			}
+
+			std::ostringstream where;
+
+			where << "  " << sites[k]->file << ":" << sites[k]->line;
+
+			dump_site(out, *sites[k], where.str());
+		}
+	}
+
+	g_lockstats_mutex.unlock();
+}
+
+} // clever
@@ -0,0 +1,90 @@
+/**
+ * Clever programming language
+ * Copyright (c) Clever Team
+ *
+ * This file is distributed under the MIT license. See LICENSE for details.
+ */
+
+#ifndef CLEVER_LOCKSTATS_H
+#define CLEVER_LOCKSTATS_H
+
+#include <iostream>
+#include <string>
+#include "core/clever.h"
+
+namespace clever {
+
+/**
+ * @brief contention profile of the named locks.
+ *
+ * Only the CMutex instances with a name are profiled: the VM mutex, taken
+ * by critical blocks and on every user function call, and the locks of the
+ * std.concurrent objects, named after the location which created them.
+ * For each lock and each source location acquiring it, the number of
+ * acquisitions, how many of them had to wait, the time spent waiting for
+ * the lock, the time it was held and the time spent in Condition.wait() are
+ * recorded.
+ *
+ * An acquisition is contended when a trylock fails, so uncontended locks
+ * cost a trylock and a clock read more than usual while profiling, and
+ * nothing but a flag check when it is off.
+ */
+class LockStats {
+public:
+	typedef unsigned long long nsecs_t;
+
+	struct Site {
+		Site(const std::string& lock_, const std::string& file_, size_t line_)
+			: lock(lock_), file(file_), line(line_), acquired(0), contended(0),
+				cond_waits(0), wait(0), max_wait(0), hold(0), max_hold(0),
+				cond_wait(0) {}
+
+		std::string lock;
+		std::string file;
+		size_t line;
+		size_t acquired;
+		size_t contended;
+		size_t cond_waits;
+		nsecs_t wait;
+		nsecs_t max_wait;
+		nsecs_t hold;
+		nsecs_t max_hold;
+		nsecs_t cond_wait;
+	};
+
+	/// Starts profiling, dropping the data recorded so far
+	static void start();
+
+	/// Stops profiling, keeping the data recorded so far
+	static void stop();
+
+	static bool isEnabled() { return s_enabled; }
+
+	/// Returns a stable pointer to be used as a lock name
+	static const std::string* intern(const std::string& name);
+
+	/// Returns `kind' followed by the running location, which names the
+	/// locks created by scripts
+	static std::string nameHere(const char* kind);
+
+	/// Records an acquisition of the named lock at the running location,
+	/// returns the site to be passed to released()
+	static Site* acquired(const std::string* lock, bool contended, nsecs_t wait);
+
+	/// Records the release of a lock held for `hold' nanoseconds
+	static void released(Site* site, nsecs_t hold);
+
+	/// Records a Condition.wait() made while holding the lock
+	static void waited(Site* site, nsecs_t wait);
+
+	/// Writes the locks ordered by wait time, each followed by its sites
+	static void dump(std::ostream& out);
+
+	static nsecs_t now();
+private:
+	static bool s_enabled;
+};
+
+} // clever
+
+#endif // CLEVER_LOCKSTATS_H
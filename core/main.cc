@@ -5,10 +5,20 @@
  * This file is distributed under the MIT license. See LICENSE for details.
  */
 
+#include <cstdlib>
+#include <fstream>
 #include <iostream>
 #include "core/compiler.h"
 #include "core/clever.h"
 #include "core/driver.h"
+#include "core/memstats.h"
+#include "core/heapsnapshot.h"
+#include "core/profiler.h"
+#include "core/opstats.h"
+#include "core/timings.h"
+#include "core/lockstats.h"
+#include "core/tracer.h"
+#include "core/zygote.h"
 #ifdef _WIN32
 #include "win32/win32.h"
 #endif
@@ -30,6 +40,23 @@ static void show_usage()
 
 	std::cout << "\t-h\tHelp\n"
 				 "\t-v\tShow version\n"
+				 "\t--mem-stats\tShow memory statistics at the end of the run\n"
+				 "\t--alloc-profile <rate>\n"
+				 "\t\tShow the allocation sites at the end of the run, sampling\n"
+				 "\t\tone in every <rate> allocations\n"
+				 "\t--heap-snapshot <prefix>\n"
+				 "\t\tWrite <prefix>.<n>.heapsnapshot on SIGUSR2\n"
+				 "\t--profile <file>\n"
+				 "\t\tProfile the run, writing collapsed stacks to <file> and\n"
+				 "\t\tthe self/total time per function and line to stderr\n"
+				 "\t--lock-stats\tShow the contention of the VM and std.concurrent locks\n"
+				 "\t--timings\tShow the time and allocations of each interpreter phase\n"
+				 "\t--trace <file>\n"
+				 "\t\tTrace every call, writing the call graph to <file> in the\n"
+				 "\t\tcallgrind format\n"
+				 "\t--server <socket>\n"
+				 "\t\tRun the scripts sent by clever-client on <socket>, each one\n"
+				 "\t\tin a process forked from an initialized runtime\n"
 				 "\n";
 
 	std::cout << "Code options (must be the last one and unique):\n"
@@ -38,6 +65,13 @@ static void show_usage()
 				 "\t-qr\tQuickly run the code (import std automatically)\n"
 				 "\n";
 
+#ifdef CLEVER_OPCODE_STATS
+	std::cout << "Instrumentation options:\n"
+				 "\t--opcode-stats\tShow opcode dispatch counts at the end of the run\n"
+				 "\t--opcode-cycles\tAlso measure the cycles spent on each opcode\n"
+				 "\n";
+#endif
+
 #ifdef CLEVER_DEBUG
 	std::cout << "Debug options:\n"
 				 "\t-a\tDump AST\n"
@@ -49,6 +83,72 @@ static void show_usage()
 #endif
 }
 
+// Reports enabled on the command line
+static bool g_mem_stats = false;
+static const char* g_profile = NULL;
+static const char* g_trace = NULL;
+static std::string g_trace_cmd = "clever";
+static bool g_reports_written = false;
+static bool g_timings_written = false;
+
+/// Writes the reports of the run, once: when the script ends, or from exit()
+/// when it calls sys:exit()
+static void write_reports()
+{
+	if (g_reports_written) {
+		return;
+	}
+	g_reports_written = true;
+
+	if (g_trace) {
+		std::ofstream out(g_trace);
+
+		clever::Tracer::stop();
+		clever::Tracer::write(out, g_trace_cmd);
+	}
+
+	if (g_profile) {
+		std::ofstream out(g_profile);
+
+		clever::Profiler::stop();
+		clever::Profiler::writeStacks(out);
+		clever::Profiler::writeReport(std::cerr);
+	}
+
+	if (clever::LockStats::isEnabled()) {
+		clever::LockStats::stop();
+		clever::LockStats::dump(std::cerr);
+	}
+
+	if (g_mem_stats) {
+		clever::MemStats::dump(std::cerr);
+	}
+	if (clever::MemStats::getSampleRate()) {
+		clever::MemStats::dumpSites(std::cerr);
+	}
+}
+
+/// Writes the phase timings, once: after the shutdown when the script ends,
+/// or from exit(), with the phases left open, when it calls sys:exit()
+static void write_timings()
+{
+	if (g_timings_written) {
+		return;
+	}
+	g_timings_written = true;
+
+	if (clever::Timings::isEnabled()) {
+		clever::Timings::dump(std::cerr);
+	}
+}
+
+/// Writes what the script did not get to write, when it calls sys:exit()
+static void write_exit_reports()
+{
+	write_reports();
+	write_timings();
+}
+
 int main(int argc, char **argv)
 {
 	//std::ios::sync_with_stdio(false);
@@ -93,17 +193,74 @@ int main(int argc, char **argv)
 				CreateBackgroundProcess(cline);
 				return 0;
 			}
+#endif
+		} else if (argv[i] == std::string("--mem-stats")) {
+			inc_arg++;
+			g_mem_stats = true;
+			clever::MemStats::enable();
+		} else if (argv[i] == std::string("--lock-stats")) {
+			inc_arg++;
+			clever::LockStats::start();
+		} else if (argv[i] == std::string("--timings")) {
+			inc_arg++;
+			clever::Timings::enable();
+			clever::MemStats::enable();
+		} else if (argv[i] == std::string("--alloc-profile")) {
+			MORE_ARG();
+			inc_arg += 2;
+
+			long rate = atol(argv[i]);
+
+			if (rate < 1) {
+				std::cerr << "Invalid sample rate '" << argv[i] << "'" << std::endl;
+				exit(1);
+			}
+			clever::MemStats::setSampleRate(rate);
+		} else if (argv[i] == std::string("--heap-snapshot")) {
+			MORE_ARG();
+			inc_arg += 2;
+			clever::HeapSnapshot::setSignalPath(argv[i]);
+		} else if (argv[i] == std::string("--profile")) {
+			MORE_ARG();
+			inc_arg += 2;
+			g_profile = argv[i];
+		} else if (argv[i] == std::string("--trace")) {
+			MORE_ARG();
+			inc_arg += 2;
+			g_trace = argv[i];
+		} else if (argv[i] == std::string("--server")) {
+			MORE_ARG();
+
+			// Only returns in the processes forked to run the scripts, with
+			// the arguments of the client, parsed as if they were ours
+			if (!clever::Zygote::serve(clever, argv[i], &argc, &argv)) {
+				exit(1);
+			}
+			inc_arg = 0;
+			i = 0;
+#ifdef CLEVER_OPCODE_STATS
+		} else if (argv[i] == std::string("--opcode-stats")) {
+			inc_arg++;
+			clever::OpStats::enable();
+		} else if (argv[i] == std::string("--opcode-cycles")) {
+			inc_arg++;
+			clever::OpStats::enableCycles();
 #endif
 		} else if (argv[i] == std::string("-i")) {
 			std::string input_line;
 			inc_arg++;
+			// Each line is compiled and run on top of the previous ones
+			clever.setCompilerFlags(clever::Compiler::INTERACTIVE);
+			atexit(write_exit_reports);
 			while (std::cin) {
 				getline(std::cin, input_line);
 				if (clever.loadStr(input_line + '\n', false) == 0) {
 					clever.execute(true);
 				}
 			}
+			write_reports();
 			clever.shutdown();
+			write_timings();
 			return 0;
 		} else if (argv[i] == std::string("-r")) {
 			MORE_ARG();
@@ -142,6 +299,8 @@ int main(int argc, char **argv)
 			std::cerr << "Unknown option '" << argv[i] << "'" << std::endl;
 			exit(1);
 		} else {
+			g_trace_cmd += std::string(" ") + argv[i];
+
 			if (clever.loadFile(argv[i])) {
 				clever.shutdown();
 				exit(1);
@@ -153,8 +312,30 @@ int main(int argc, char **argv)
 	argc -= inc_arg + 1;
 	argv += inc_arg + 1;
 
+	if (g_profile && !clever::Profiler::start()) {
+		std::cerr << "Couldn't start the profiler" << std::endl;
+		exit(1);
+	}
+
+	if (g_trace) {
+		clever::Tracer::start();
+	}
+
+	atexit(write_exit_reports);
+
 	clever.execute(false);
+
+#ifdef CLEVER_OPCODE_STATS
+	if (clever::OpStats::isEnabled()) {
+		clever::OpStats::dump(std::cerr);
+	}
+#endif
+
+	write_reports();
+
 	clever.shutdown();
 
+	write_timings();
+
 	return 0;
 }
@@ -0,0 +1,261 @@
+/**
+ * Clever programming language
+ * Copyright (c) Clever Team
+ *
+ * This file is distributed under the MIT license. See LICENSE for details.
+ */
+
+#include <algorithm>
+#include <iomanip>
+#include <map>
+#include "core/memstats.h"
+#include "core/cthread.h"
+#include "core/value.h"
+#include "core/environment.h"
+#include "core/vm.h"
+#include "core/user.h"
+#include "core/location.hh"
+#include "modules/std/core/array.h"
+#include "modules/std/core/map.h"
+#include "modules/std/core/function.h"
+
+namespace clever {
+
+MemCounter MemStats::s_counters[MemStats::NUM_KINDS];
+bool MemStats::s_enabled = false;
+size_t MemStats::s_sample_rate = 0;
+size_t MemStats::s_sample_tick = 0;
+
+struct TypeCounter {
+	TypeCounter(const std::string& name_, TypeCounter* next_)
+		: name(name_), counter(name.c_str()), next(next_) {}
+
+	std::string name;
+	MemCounter counter;
+	TypeCounter* next;
+};
+
+/// A script line, the file name and the line number
+typedef std::pair<std::string, unsigned int> AllocSiteKey;
+
+struct AllocSite {
+	AllocSite()
+		: allocs(0), bytes(0), func() {}
+
+	size_t allocs;
+	size_t bytes;
+
+	/// Function running the line when it was first sampled
+	std::string func;
+};
+
+typedef std::map<AllocSiteKey, AllocSite> AllocSiteMap;
+typedef std::pair<AllocSiteKey, AllocSite> AllocSitePair;
+
+// Registered type counters, kept reachable until the process exits
+static TypeCounter* g_type_counters = NULL;
+static CMutex g_type_counters_mutex;
+
+// Sampled allocations, per script line
+static AllocSiteMap g_alloc_sites;
+static CMutex g_alloc_sites_mutex;
+
+static bool sort_by_live(const MemStats::Entry& a, const MemStats::Entry& b)
+{
+	if (a.second.live != b.second.live) {
+		return a.second.live > b.second.live;
+	}
+	return a.second.allocs > b.second.allocs;
+}
+
+static bool sort_by_bytes(const AllocSitePair& a, const AllocSitePair& b)
+{
+	return a.second.bytes > b.second.bytes;
+}
+
+static void dump_counter(std::ostream& out, const std::string& name,
+	const MemCounter& counter, size_t size)
+{
+	out << std::left << std::setw(20) << name << std::right
+		<< std::setw(12) << counter.allocs
+		<< std::setw(12) << counter.live
+		<< std::setw(12) << counter.peak;
+
+	if (size) {
+		out << std::setw(14) << counter.live * size
+			<< std::setw(14) << counter.peak * size;
+	}
+	out << "\n";
+}
+
+const char* MemStats::getName(Kind kind)
+{
+	switch (kind) {
+		case VALUE:       return "Value";
+		case ENVIRONMENT: return "Environment";
+		case OBJECT:      return "TypeObject";
+		default:          return "unknown";
+	}
+}
+
+size_t MemStats::getSize(Kind kind)
+{
+	switch (kind) {
+		case VALUE:       return sizeof(Value);
+		case ENVIRONMENT: return sizeof(Environment);
+		case OBJECT:      return sizeof(TypeObject);
+		default:          return 0;
+	}
+}
+
+size_t MemStats::getObjectSize(const Type* type, const TypeObject* obj)
+{
+	if (type == CLEVER_STR_TYPE) {
+		return sizeof(StrObject) + static_cast<const StrObject*>(obj)->value->capacity();
+	} else if (type == CLEVER_INT_TYPE || type == CLEVER_DOUBLE_TYPE
+		|| type == CLEVER_BOOL_TYPE) {
+		return sizeof(SimpleTypeObject<double>);
+	} else if (type == CLEVER_ARRAY_TYPE) {
+		return sizeof(ArrayObject) + sizeof(ArrayStorage)
+			+ static_cast<const ArrayObject*>(obj)->getData().capacity() * sizeof(Value*);
+	} else if (type == CLEVER_MAP_TYPE) {
+		return sizeof(MapObject) + sizeof(MapStorage)
+			+ static_cast<const MapObject*>(obj)->getData().size() * sizeof(MapObjectPair);
+	} else if (type == CLEVER_FUNC_TYPE) {
+		return sizeof(Function);
+	} else if (type->isUserDefined()) {
+		return sizeof(UserObject);
+	}
+	return sizeof(TypeObject);
+}
+
+MemCounter* MemStats::registerType(const std::string& name)
+{
+	g_type_counters_mutex.lock();
+
+	TypeCounter* entry = g_type_counters;
+
+	while (entry && entry->name != name) {
+		entry = entry->next;
+	}
+
+	if (entry == NULL) {
+		entry = g_type_counters = new TypeCounter(name, g_type_counters);
+	}
+
+	g_type_counters_mutex.unlock();
+
+	return &entry->counter;
+}
+
+void MemStats::getTypes(std::vector<Entry>& out)
+{
+	g_type_counters_mutex.lock();
+
+	for (TypeCounter* entry = g_type_counters; entry; entry = entry->next) {
+		if (entry->counter.allocs) {
+			out.push_back(Entry(entry->name, entry->counter));
+		}
+	}
+
+	g_type_counters_mutex.unlock();
+}
+
+void MemStats::dump(std::ostream& out)
+{
+	std::vector<Entry> types;
+
+	getTypes(types);
+	std::sort(types.begin(), types.end(), sort_by_live);
+
+	out << "Memory statistics\n"
+		<< std::left << std::setw(20) << "class" << std::right
+		<< std::setw(12) << "allocs"
+		<< std::setw(12) << "live"
+		<< std::setw(12) << "peak"
+		<< std::setw(14) << "bytes"
+		<< std::setw(14) << "peak bytes" << "\n";
+
+	for (size_t i = 0; i < NUM_KINDS; ++i) {
+		dump_counter(out, getName(static_cast<Kind>(i)), s_counters[i],
+			getSize(static_cast<Kind>(i)));
+	}
+
+	out << "\n"
+		<< std::left << std::setw(20) << "type" << std::right
+		<< std::setw(12) << "allocs"
+		<< std::setw(12) << "live"
+		<< std::setw(12) << "peak" << "\n";
+
+	for (size_t i = 0, j = types.size(); i < j; ++i) {
+		dump_counter(out, types[i].first, types[i].second, 0);
+	}
+}
+
+void MemStats::sample(Kind kind)
+{
+	if (isSampled()) {
+		record(getSize(kind));
+	}
+}
+
+void MemStats::sampleObject(const Type* type, const TypeObject* obj)
+{
+	if (isSampled()) {
+		record(getObjectSize(type, obj));
+	}
+}
+
+void MemStats::record(size_t size)
+{
+	const VM* vm = VM::getCurrent();
+	const location* loc = vm ? vm->getLocation() : NULL;
+	AllocSiteKey key(vm ? "<internal>" : "<compiler>", 0);
+
+	if (loc) {
+		key.first = loc->begin.filename ? *loc->begin.filename : "<command line>";
+		key.second = loc->begin.line;
+	}
+
+	g_alloc_sites_mutex.lock();
+
+	AllocSite& site = g_alloc_sites[key];
+
+	if (loc && site.allocs == 0) {
+		const Function* func = vm->getFunction();
+
+		site.func = func ? func->getName() + "()" : "<main>";
+	}
+
+	site.allocs += s_sample_rate;
+	site.bytes += s_sample_rate * size;
+
+	g_alloc_sites_mutex.unlock();
+}
+
+void MemStats::dumpSites(std::ostream& out)
+{
+	g_alloc_sites_mutex.lock();
+	std::vector<AllocSitePair> sites(g_alloc_sites.begin(), g_alloc_sites.end());
+	g_alloc_sites_mutex.unlock();
+
+	std::sort(sites.begin(), sites.end(), sort_by_bytes);
+
+	out << "Allocation sites (1 in " << s_sample_rate << " allocations sampled)\n"
+		<< std::setw(14) << "bytes" << std::setw(12) << "allocs" << "  site\n";
+
+	for (size_t i = 0, j = sites.size(); i < j; ++i) {
+		const AllocSiteKey& key = sites[i].first;
+
+		out << std::setw(14) << sites[i].second.bytes
+			<< std::setw(12) << sites[i].second.allocs << "  ";
+
+		if (key.second) {
+			out << key.first << ":" << key.second << " in " << sites[i].second.func << "\n";
+		} else {
+			out << key.first << "\n";
+		}
+	}
+}
+
+} // clever
@@ -0,0 +1,172 @@
+/**
+ * Clever programming language
+ * Copyright (c) Clever Team
+ *
+ * This file is distributed under the MIT license. See LICENSE for details.
+ */
+
+#ifndef CLEVER_MEMSTATS_H
+#define CLEVER_MEMSTATS_H
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include "core/clever.h"
+
+namespace clever {
+
+class Type;
+class TypeObject;
+
+#if CLEVER_GCC_VERSION >= 4010 || defined(__clang__)
+# define CLEVER_MEMSTATS_ADD(var, n) __sync_add_and_fetch(&(var), (n))
+# define CLEVER_MEMSTATS_SUB(var, n) __sync_sub_and_fetch(&(var), (n))
+# define CLEVER_MEMSTATS_CAS(var, old, n) __sync_bool_compare_and_swap(&(var), (old), (n))
+#else
+# define CLEVER_MEMSTATS_ADD(var, n) ((var) += (n))
+# define CLEVER_MEMSTATS_SUB(var, n) ((var) -= (n))
+# define CLEVER_MEMSTATS_CAS(var, old, n) ((var) = (n), true)
+#endif
+
+/**
+ * @brief allocation counters for a runtime class or a Type.
+ *
+ * Counters are updated with atomic operations, only while the statistics
+ * are enabled (see MemStats).
+ */
+struct MemCounter {
+	explicit MemCounter(const char* name_ = NULL)
+		: name(name_), allocs(0), live(0), peak(0) {}
+
+	void alloc() {
+		size_t n = CLEVER_MEMSTATS_ADD(live, 1);
+
+		CLEVER_MEMSTATS_ADD(allocs, 1);
+
+		size_t old = peak;
+
+		while (UNEXPECTED(n > old) && !CLEVER_MEMSTATS_CAS(peak, old, n)) {
+			old = peak;
+		}
+	}
+
+	void free() { CLEVER_MEMSTATS_SUB(live, 1); }
+
+	/// Name of the type counted, NULL for the runtime classes
+	const char* name;
+	/// Total number of allocations
+	size_t allocs;
+	/// Number of instances currently alive
+	size_t live;
+	/// Highest number of instances alive at once
+	size_t peak;
+};
+
+/**
+ * @brief process wide memory statistics.
+ *
+ * Runtime classes (Value, Environment and TypeObject) have a fixed counter
+ * each; their byte counts are derived from the shallow instance size. Every
+ * Type gets a counter when it is constructed, which is attached to its
+ * objects the first time they are stored in a Value; types sharing a name
+ * share the counter. Type counters are never freed, as objects may
+ * outlive the Type that created them during shutdown.
+ *
+ * When a sample rate is set, one in every `rate` allocations of a runtime
+ * class is attributed to the backtrace of the running script, weighted by
+ * the rate, so that the report points at the lines building up memory.
+ *
+ * Counting is off until enable() is called (by --mem-stats, --alloc-profile,
+ * --timings, the first sys:memstats() call or loading std.metrics), and an
+ * allocation then only costs the test of a flag. Objects remember whether
+ * they were counted, so the live counts stay exact whenever it is enabled.
+ */
+class MemStats {
+public:
+	enum Kind {
+		VALUE,
+		ENVIRONMENT,
+		OBJECT,
+		NUM_KINDS
+	};
+
+	typedef std::pair<std::string, MemCounter> Entry;
+
+	/// Counts an allocation, returns whether it was counted, to be passed
+	/// to free() when the instance is destroyed
+	static bool alloc(Kind kind) {
+		if (EXPECTED(!s_enabled)) {
+			return false;
+		}
+
+		s_counters[kind].alloc();
+
+		// Objects are sampled once their type is known, see sampleObject()
+		if (UNEXPECTED(s_sample_rate != 0) && kind != OBJECT) {
+			sample(kind);
+		}
+		return true;
+	}
+	static void free(Kind kind, bool counted) {
+		if (UNEXPECTED(counted)) {
+			s_counters[kind].free();
+		}
+	}
+
+	/// Starts counting the allocations made from now on, for good
+	static void enable() { s_enabled = true; }
+	static bool isEnabled() { return s_enabled; }
+
+	static const MemCounter& get(Kind kind) { return s_counters[kind]; }
+	static const char* getName(Kind kind);
+
+	/// Returns the shallow size of an instance of the runtime class
+	static size_t getSize(Kind kind);
+
+	/// Returns the size of an object, with the storage it owns
+	static size_t getObjectSize(const Type*, const TypeObject*);
+
+	/// Returns the counter to be used by the objects of the named type
+	static MemCounter* registerType(const std::string& name);
+
+	/// Copies the current per type counters into `out`
+	static void getTypes(std::vector<Entry>& out);
+
+	/// Writes a human readable report
+	static void dump(std::ostream& out);
+
+	/// Enables allocation site sampling, 0 disables it
+	static void setSampleRate(size_t rate) {
+		s_sample_rate = rate;
+
+		if (rate) {
+			enable();
+		}
+	}
+	static size_t getSampleRate() { return s_sample_rate; }
+
+	/// Samples the allocation of an object which was just given its type
+	static void sampleObject(const Type*, const TypeObject*);
+
+	/// Writes the sampled allocation sites, per script line, sorted by bytes
+	static void dumpSites(std::ostream& out);
+private:
+	static void sample(Kind kind);
+
+	/// Whether the allocation being made is one of the sampled ones
+	static bool isSampled() {
+		return CLEVER_MEMSTATS_ADD(s_sample_tick, 1) % s_sample_rate == 0;
+	}
+
+	/// Attributes a sampled allocation to the script line being executed
+	static void record(size_t size);
+
+	static MemCounter s_counters[NUM_KINDS];
+	static bool s_enabled;
+	static size_t s_sample_rate;
+	static size_t s_sample_tick;
+};
+
+} // clever
+
+#endif // CLEVER_MEMSTATS_H
@@ -0,0 +1,354 @@
+/**
+ * Clever programming language
+ * Copyright (c) Clever Team
+ *
+ * This file is distributed under the MIT license. See LICENSE for details.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <ctime>
+#include <map>
+#include <sstream>
+#include "core/metrics.h"
+#include "core/cthread.h"
+
+namespace clever {
+
+THREAD_TLS Metrics::CallCounts* Metrics::t_counts = NULL;
+std::vector<Metrics::CallCounts*> Metrics::s_counts;
+Metric* Metrics::s_native_time = NULL;
+size_t Metrics::s_exceptions = 0;
+size_t Metrics::s_threads_started = 0;
+size_t Metrics::s_threads_running = 0;
+bool Metrics::s_time_native = false;
+
+typedef std::map<std::string, Metric*> MetricMap;
+
+// Registered metrics, sorted by name; they live until the process exits
+static MetricMap g_metrics;
+static CMutex g_metrics_mutex;
+
+static const char* RESERVED_PREFIX = "clever_";
+
+static std::string format_value(double value)
+{
+	std::ostringstream out;
+
+	if (value != value) {
+		return "NaN";
+	} else if (value == HUGE_VAL) {
+		return "+Inf";
+	} else if (value == -HUGE_VAL) {
+		return "-Inf";
+	}
+
+	out.precision(15);
+	out << value;
+
+	return out.str();
+}
+
+/// Escapes the backslashes and line breaks of a HELP line
+static std::string escape_help(const std::string& help)
+{
+	std::string out;
+
+	for (size_t i = 0, j = help.size(); i < j; ++i) {
+		if (help[i] == '\\') {
+			out += "\\\\";
+		} else if (help[i] == '\n') {
+			out += "\\n";
+		} else {
+			out += help[i];
+		}
+	}
+	return out;
+}
+
+static void render_header(std::ostream& out, const std::string& name,
+	const std::string& help, const char* type)
+{
+	if (!help.empty()) {
+		out << "# HELP " << name << " " << help << "\n";
+	}
+	out << "# TYPE " << name << " " << type << "\n";
+}
+
+void Metric::add(double value)
+{
+	m_value += value;
+}
+
+void Metric::set(double value)
+{
+	m_value = value;
+}
+
+void Metric::setBuckets(const std::vector<double>& bounds)
+{
+	m_bounds = bounds;
+	std::sort(m_bounds.begin(), m_bounds.end());
+	m_buckets.assign(m_bounds.size(), 0);
+}
+
+void Metric::observe(double value)
+{
+	size_t bucket = std::lower_bound(m_bounds.begin(), m_bounds.end(), value)
+		- m_bounds.begin();
+
+	if (bucket < m_buckets.size()) {
+		++m_buckets[bucket];
+	}
+
+	m_value += value;
+	++m_count;
+}
+
+void Metric::render(std::ostream& out) const
+{
+	static const char* kinds[] = { "counter", "gauge", "histogram" };
+
+	render_header(out, m_name, escape_help(m_help), kinds[m_kind]);
+
+	if (m_kind != HISTOGRAM) {
+		out << m_name << " " << format_value(m_value) << "\n";
+		return;
+	}
+
+	size_t cumulative = 0;
+
+	for (size_t i = 0, j = m_bounds.size(); i < j; ++i) {
+		cumulative += m_buckets[i];
+
+		out << m_name << "_bucket{le=\"" << format_value(m_bounds[i]) << "\"} "
+			<< cumulative << "\n";
+	}
+
+	out << m_name << "_bucket{le=\"+Inf\"} " << m_count << "\n"
+		<< m_name << "_sum " << format_value(m_value) << "\n"
+		<< m_name << "_count " << m_count << "\n";
+}
+
+Metrics::nsecs_t Metrics::now()
+{
+#ifndef CLEVER_WIN32
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return nsecs_t(ts.tv_sec) * 1000000000ULL + ts.tv_nsec;
+#else
+	LARGE_INTEGER freq, count;
+
+	QueryPerformanceFrequency(&freq);
+	QueryPerformanceCounter(&count);
+
+	return nsecs_t(count.QuadPart) * 1000000000ULL / freq.QuadPart;
+#endif
+}
+
+Metrics::CallCounts* Metrics::newCallCounts()
+{
+	CallCounts* counts = new CallCounts;
+
+	// Kept until the process exits, the counts of finished threads still add up
+	g_metrics_mutex.lock();
+	s_counts.push_back(counts);
+	g_metrics_mutex.unlock();
+
+	return counts;
+}
+
+void Metrics::observeNative(nsecs_t nsecs)
+{
+	g_metrics_mutex.lock();
+
+	if (UNEXPECTED(s_native_time == NULL)) {
+		std::vector<double> bounds;
+
+		s_native_time = new Metric("clever_native_call_seconds",
+			"Time spent in internal function calls.", Metric::HISTOGRAM);
+
+		// 1us to 1s
+		for (double bound = 1e-6; bound < 2; bound *= 10) {
+			bounds.push_back(bound);
+		}
+		s_native_time->setBuckets(bounds);
+	}
+
+	s_native_time->observe(nsecs / 1e9);
+
+	g_metrics_mutex.unlock();
+}
+
+bool Metrics::isValidName(const std::string& name)
+{
+	if (name.empty() || (name[0] >= '0' && name[0] <= '9')) {
+		return false;
+	}
+
+	for (size_t i = 0, j = name.size(); i < j; ++i) {
+		char c = name[i];
+
+		if (!((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z')
+			|| (c >= '0' && c <= '9') || c == '_' || c == ':')) {
+			return false;
+		}
+	}
+	return true;
+}
+
+bool Metrics::isReservedName(const std::string& name)
+{
+	return name.compare(0, std::strlen(RESERVED_PREFIX), RESERVED_PREFIX) == 0;
+}
+
+Metric* Metrics::get(const std::string& name, Metric::Kind kind,
+	const std::string& help)
+{
+	if (!isValidName(name) || isReservedName(name)) {
+		return NULL;
+	}
+
+	g_metrics_mutex.lock();
+
+	MetricMap::const_iterator it = g_metrics.find(name);
+	Metric* metric;
+
+	if (it != g_metrics.end()) {
+		metric = it->second->getKind() == kind ? it->second : NULL;
+	} else {
+		metric = new Metric(name, help, kind);
+
+		if (kind == Metric::HISTOGRAM) {
+			// Prometheus client defaults, in seconds
+			static const double defaults[] = {
+				.005, .01, .025, .05, .1, .25, .5, 1, 2.5, 5, 10
+			};
+			std::vector<double> bounds(defaults,
+				defaults + sizeof(defaults) / sizeof(defaults[0]));
+
+			metric->setBuckets(bounds);
+		}
+
+		g_metrics.insert(MetricMap::value_type(name, metric));
+	}
+
+	g_metrics_mutex.unlock();
+
+	return metric;
+}
+
+Metric* Metrics::find(const std::string& name)
+{
+	g_metrics_mutex.lock();
+
+	MetricMap::const_iterator it = g_metrics.find(name);
+	Metric* metric = it != g_metrics.end() ? it->second : NULL;
+
+	g_metrics_mutex.unlock();
+
+	return metric;
+}
+
+void Metrics::add(Metric* metric, double value)
+{
+	g_metrics_mutex.lock();
+	metric->add(value);
+	g_metrics_mutex.unlock();
+}
+
+void Metrics::set(Metric* metric, double value)
+{
+	g_metrics_mutex.lock();
+	metric->set(value);
+	g_metrics_mutex.unlock();
+}
+
+void Metrics::observe(Metric* metric, double value)
+{
+	g_metrics_mutex.lock();
+	metric->observe(value);
+	g_metrics_mutex.unlock();
+}
+
+void Metrics::render(std::ostream& out)
+{
+	std::vector<MemStats::Entry> types;
+	size_t user_calls = 0, native_calls = 0;
+
+	g_metrics_mutex.lock();
+
+	for (size_t i = 0, j = s_counts.size(); i < j; ++i) {
+		user_calls += s_counts[i]->user;
+		native_calls += s_counts[i]->native;
+	}
+
+	g_metrics_mutex.unlock();
+
+	render_header(out, "clever_calls_total", "User function calls executed.", "counter");
+	out << "clever_calls_total " << user_calls << "\n";
+
+	render_header(out, "clever_native_calls_total", "Internal function calls executed.",
+		"counter");
+	out << "clever_native_calls_total " << native_calls << "\n";
+
+	render_header(out, "clever_exceptions_total", "Exceptions thrown.", "counter");
+	out << "clever_exceptions_total " << s_exceptions << "\n";
+
+	render_header(out, "clever_threads_started_total", "Script threads started.", "counter");
+	out << "clever_threads_started_total " << s_threads_started << "\n";
+
+	render_header(out, "clever_threads", "Script threads running.", "gauge");
+	out << "clever_threads " << s_threads_running << "\n";
+
+	render_header(out, "clever_runtime_allocations_total",
+		"Runtime class instances allocated.", "counter");
+	for (size_t i = 0; i < MemStats::NUM_KINDS; ++i) {
+		MemStats::Kind kind = static_cast<MemStats::Kind>(i);
+
+		out << "clever_runtime_allocations_total{class=\"" << MemStats::getName(kind)
+			<< "\"} " << MemStats::get(kind).allocs << "\n";
+	}
+
+	render_header(out, "clever_runtime_live", "Runtime class instances alive.", "gauge");
+	for (size_t i = 0; i < MemStats::NUM_KINDS; ++i) {
+		MemStats::Kind kind = static_cast<MemStats::Kind>(i);
+
+		out << "clever_runtime_live{class=\"" << MemStats::getName(kind)
+			<< "\"} " << MemStats::get(kind).live << "\n";
+	}
+
+	MemStats::getTypes(types);
+
+	render_header(out, "clever_objects_allocated_total", "Objects allocated per type.",
+		"counter");
+	for (size_t i = 0, j = types.size(); i < j; ++i) {
+		out << "clever_objects_allocated_total{type=\"" << types[i].first << "\"} "
+			<< types[i].second.allocs << "\n";
+	}
+
+	render_header(out, "clever_objects_live", "Objects alive per type.", "gauge");
+	for (size_t i = 0, j = types.size(); i < j; ++i) {
+		out << "clever_objects_live{type=\"" << types[i].first << "\"} "
+			<< types[i].second.live << "\n";
+	}
+
+	g_metrics_mutex.lock();
+
+	if (s_native_time) {
+		s_native_time->render(out);
+	}
+
+	MetricMap::const_iterator it(g_metrics.begin()), end(g_metrics.end());
+
+	for (; it != end; ++it) {
+		it->second->render(out);
+	}
+
+	g_metrics_mutex.unlock();
+}
+
+} // clever
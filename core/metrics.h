@@ -0,0 +1,164 @@
+/**
+ * Clever programming language
+ * Copyright (c) Clever Team
+ *
+ * This file is distributed under the MIT license. See LICENSE for details.
+ */
+
+#ifndef CLEVER_METRICS_H
+#define CLEVER_METRICS_H
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include "core/clever.h"
+#include "core/memstats.h"
+
+namespace clever {
+
+/// A counter, gauge or histogram of the metrics registry
+class Metric {
+public:
+	enum Kind {
+		COUNTER,
+		GAUGE,
+		HISTOGRAM
+	};
+
+	Metric(const std::string& name, const std::string& help, Kind kind)
+		: m_name(name), m_help(help), m_kind(kind), m_value(0), m_count(0) {}
+
+	const std::string& getName() const { return m_name; }
+	Kind getKind() const { return m_kind; }
+
+	/// Adds to a counter or a gauge
+	void add(double value);
+
+	/// Sets a gauge
+	void set(double value);
+
+	/// Records a histogram observation
+	void observe(double value);
+
+	/// Sets the histogram upper bounds, sorted ascending
+	void setBuckets(const std::vector<double>&);
+
+	double getValue() const { return m_value; }
+
+	/// Writes the metric in the Prometheus text format
+	void render(std::ostream&) const;
+private:
+	std::string m_name;
+	std::string m_help;
+	Kind m_kind;
+
+	/// Counter and gauge value, histogram sum
+	double m_value;
+
+	/// Histogram observations, in total and per bucket (not cumulative)
+	size_t m_count;
+	std::vector<double> m_bounds;
+	std::vector<size_t> m_buckets;
+
+	DISALLOW_COPY_AND_ASSIGN(Metric);
+};
+
+/**
+ * @brief process wide metrics registry.
+ *
+ * The VM feeds a fixed set of counters (calls, exceptions, threads); the
+ * call counters are kept per thread and summed when rendered, the rarer
+ * events use atomic adds. Timing internal function calls needs two clock
+ * reads per call, so it is only done after enableNativeTiming(). Object
+ * counts come from MemStats when the metrics are rendered. Scripts may
+ * register their own metrics through std.metrics, the names starting with
+ * `clever_' are reserved for the built-in ones.
+ *
+ * render() produces the Prometheus text exposition format (version 0.0.4).
+ */
+class Metrics {
+public:
+	typedef unsigned long long nsecs_t;
+
+	/// Counts an user function call
+	static void userCall() { ++getCallCounts()->user; }
+
+	/// Counts an internal function call, returns its start time when timed
+	static nsecs_t nativeEnter() {
+		++getCallCounts()->native;
+
+		return UNEXPECTED(s_time_native) ? now() : 0;
+	}
+
+	/// Records the time spent in an internal function call
+	static void nativeLeave(nsecs_t start) {
+		if (UNEXPECTED(start != 0)) {
+			observeNative(now() - start);
+		}
+	}
+
+	static void exceptionThrown() { CLEVER_MEMSTATS_ADD(s_exceptions, 1); }
+
+	static void threadStarted() {
+		CLEVER_MEMSTATS_ADD(s_threads_started, 1);
+		CLEVER_MEMSTATS_ADD(s_threads_running, 1);
+	}
+	static void threadFinished() { CLEVER_MEMSTATS_SUB(s_threads_running, 1); }
+
+	static void enableNativeTiming(bool enable) { s_time_native = enable; }
+
+	/// Returns the named metric, registering it when it does not exist;
+	/// NULL if the name is invalid, reserved or used by a metric of another kind
+	static Metric* get(const std::string& name, Metric::Kind kind,
+		const std::string& help = "");
+
+	/// Returns the named metric, NULL if there is none
+	static Metric* find(const std::string& name);
+
+	/// Checks the name against the Prometheus naming rules
+	static bool isValidName(const std::string& name);
+
+	/// Checks whether the name belongs to the built-in metrics
+	static bool isReservedName(const std::string& name);
+
+	/// Adds to a counter or gauge, sets a gauge or records an observation,
+	/// holding the registry lock
+	static void add(Metric*, double);
+	static void set(Metric*, double);
+	static void observe(Metric*, double);
+
+	/// Writes every metric in the Prometheus text format
+	static void render(std::ostream& out);
+private:
+	/// Call counts of a thread, only written by that thread
+	struct CallCounts {
+		CallCounts() : user(0), native(0) {}
+
+		size_t user;
+		size_t native;
+	};
+
+	static CallCounts* getCallCounts() {
+		if (UNEXPECTED(t_counts == NULL)) {
+			t_counts = newCallCounts();
+		}
+		return t_counts;
+	}
+
+	static CallCounts* newCallCounts();
+
+	static nsecs_t now();
+	static void observeNative(nsecs_t);
+
+	static THREAD_TLS CallCounts* t_counts;
+	static std::vector<CallCounts*> s_counts;
+	static Metric* s_native_time;
+	static size_t s_exceptions;
+	static size_t s_threads_started;
+	static size_t s_threads_running;
+	static bool s_time_native;
+};
+
+} // clever
+
+#endif // CLEVER_METRICS_H
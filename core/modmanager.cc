@@ -10,6 +10,8 @@
 #include "core/modmanager.h"
 #include "core/value.h"
 #include "core/cstring.h"
+#include "core/probes.h"
+#include "core/timings.h"
 #include "core/scope.h"
 #include "modules/std/std_pkg.h"
 #include "modules/db/db_pkg.h"
@@ -57,19 +59,62 @@ void ModManager::addModule(const std::string& name, Module* module)
 		return;
 	}
 
+	// Packages only register the factories of their modules
 	m_mods.insert(ModuleMap::value_type(name, module));
 	module->init();
 	module->setLoaded();
+}
+
+/// Finds a module, creating it on its first import, NULL if there is none
+Module* ModManager::findModule(const std::string& name) const
+{
+	ModuleMap::const_iterator it(m_mods.find(name));
+
+	if (it != m_mods.end()) {
+		return it->second;
+	}
+
+	// Modules are registered by the package named by their prefix, the ones
+	// out of our packages can still be provided by a plugin
+	ModuleMap::const_iterator pkg(m_mods.find(name.substr(0, name.find('.'))));
+	Module* module;
+
+	if (pkg != m_mods.end()) {
+		module = pkg->second->getModule(name);
+	} else {
+		module = Plugin::load(name);
+	}
+
+	if (module) {
+		m_mods.insert(ModuleMap::value_type(name, module));
+	}
+	return module;
+}
 
+/// Creates and initializes a module, its submodules and their types ahead of
+/// their import, which then only has to declare them
+void ModManager::preloadModule(Module* module) const
+{
 	if (module->hasModules()) {
 		ModuleMap& mods = module->getModules();
 		ModuleMap::const_iterator it(mods.begin()), end(mods.end());
 
-		while (it != end) {
+		for (; it != end; ++it) {
+			// Owned by us once created
 			m_mods.insert(ModuleMap::value_type(it->first, it->second));
-			++it;
+
+			preloadModule(it->second);
 		}
 	}
+
+	module->initialize();
+
+	TypeMap& types = module->getTypes();
+	TypeMap::const_iterator itt(types.begin()), ite(types.end());
+
+	for (; itt != ite; ++itt) {
+		itt->second->initialize();
+	}
 }
 
 /// Loads an specific module type
@@ -79,7 +124,7 @@ void ModManager::loadType(Scope* scope, const std::string& name, Type* type) con
 
 	scope->pushValue(CSTRING(name), tmp);
 
-	type->init();
+	type->initialize();
 }
 
 /// Loads an specific module function
@@ -171,11 +216,14 @@ void ModManager::loadModule(Scope* scope, Module* module,
 		ModuleMap::const_iterator it(mods.begin()), end(mods.end());
 
 		while (it != end) {
+			// Owned by us once created
+			m_mods.insert(ModuleMap::value_type(it->first, it->second));
+
 			if (it->second->isLoaded()) {
 				++it;
 				continue;
 			}
-			it->second->init();
+			it->second->initialize();
 			it->second->setLoaded();
 
 			std::string prefix = it->second->getName() + ":";
@@ -195,7 +243,7 @@ void ModManager::loadModule(Scope* scope, Module* module,
 		return;
 	}
 
-	module->init();
+	module->initialize();
 	module->setLoaded();
 
 	std::string ns_prefix = "";
@@ -237,11 +285,13 @@ ast::Node* ModManager::importFile(Scope* scope,
 ast::Node* ModManager::importModule(Scope* scope,
 	const std::string& module, size_t kind, const CString* name) const
 {
-	ModuleMap::const_iterator it(m_mods.find(module));
+	CLEVER_PROBE1(module__import, module.c_str());
+
+	TimingScope timing("import", module);
 
-	//std::cout << "imp " << module << std::endl;
+	Module* mod = findModule(module);
 
-	if (it == m_mods.end()) {
+	if (!mod) {
 		ast::Node* tree;
 
 		if ((tree = importFile(scope, module, kind, name)) == NULL) {
@@ -251,7 +301,7 @@ ast::Node* ModManager::importModule(Scope* scope,
 		return tree;
 	}
 
-	loadModule(scope, it->second, kind, name);
+	loadModule(scope, mod, kind, name);
 
 	return NULL;
 }
@@ -52,6 +52,11 @@ public:
 	/// Adds a new package to the map
 	void addModule(const std::string&, Module*);
 
+	Module* findModule(const std::string&) const;
+
+	/// Creates and initializes a module and everything it contains
+	void preloadModule(Module*) const;
+
 	/// Imports the module to the current scope
 	ast::Node* importModule(Scope*, const std::string&,
 		size_t = ModManager::ALL, const CString* = NULL) const;
@@ -66,7 +71,7 @@ public:
 	void loadType(Scope*, const std::string&, Type*) const;
 private:
 	Driver* m_driver;
-	ModuleMap m_mods;
+	mutable ModuleMap m_mods;
 	Module* m_user;
 	std::string m_include_path;
 };
@@ -15,6 +15,7 @@
 #endif
 #include <string>
 #include "core/type.h"
+#include "core/plugin.h"
 #include "modules/std/core/function.h"
 
 #define CLEVER_MODULE_INIT(x) void x::init()
@@ -32,10 +33,20 @@ typedef std::tr1::unordered_map<std::string, Module*> ModuleMap;
 typedef std::tr1::unordered_map<std::string, Value*> VarMap;
 typedef std::tr1::unordered_map<std::string, Function*> FunctionMap;
 
+/// Creates a submodule, on its first import
+typedef Module* (*ModuleFactory)();
+typedef std::tr1::unordered_map<std::string, ModuleFactory> ModuleFactoryMap;
+
+/// Returns the factory of a module class
+template <typename T>
+Module* module_factory() {
+	return new T;
+}
+
 /// Module representation
 class Module {
 public:
-	enum ModuleStatus { UNLOADED, LOADED };
+	enum ModuleStatus { UNLOADED, INITIALIZED, LOADED };
 
 	Module(const std::string& name)
 		: m_name(name), m_flags(UNLOADED) {}
@@ -50,6 +61,17 @@ public:
 		m_mods.insert(ModuleMap::value_type(mod->getName(), mod));
 	}
 
+	/// Registers a submodule, which is only created when imported
+	void addModule(const std::string& name, ModuleFactory factory) {
+		m_factories.insert(ModuleFactoryMap::value_type(name, factory));
+	}
+
+	/// Registers a submodule built as a plugin, which is only loaded when
+	/// imported
+	void addPlugin(const std::string& name) {
+		m_factories.insert(ModuleFactoryMap::value_type(name, NULL));
+	}
+
 	void addType(Type* type) {
 		m_types.insert(TypeMap::value_type(type->getName(), type));
 	}
@@ -59,22 +81,65 @@ public:
 		return func;
 	}
 
-	ModuleMap& getModules() { return m_mods; }
+	/// Returns a submodule, creating it if needed, NULL if there is none
+	Module* getModule(const std::string& name) {
+		ModuleMap::const_iterator it(m_mods.find(name));
+
+		if (it != m_mods.end()) {
+			return it->second;
+		}
+
+		ModuleFactoryMap::iterator factory(m_factories.find(name));
+
+		if (factory == m_factories.end()) {
+			return NULL;
+		}
+
+		// Plugins have no factory, it is provided by their library
+		Module* mod = factory->second ? factory->second() : Plugin::load(name);
+
+		m_factories.erase(factory);
+
+		if (!mod) {
+			return NULL;
+		}
+		addModule(mod);
+
+		return mod;
+	}
+
+	/// Returns the submodules, creating the ones not imported yet
+	ModuleMap& getModules() {
+		while (!m_factories.empty()) {
+			getModule(m_factories.begin()->first);
+		}
+		return m_mods;
+	}
+
 	TypeMap& getTypes() { return m_types; }
 	VarMap& getVars() { return m_vars; }
 	FunctionMap& getFunctions() { return m_funcs; }
 
-	bool hasModules() const { return !m_mods.empty(); }
+	bool hasModules() const { return !m_mods.empty() || !m_factories.empty(); }
 
 	const std::string& getName() { return m_name; }
 
 	void setLoaded() { m_flags = LOADED; }
 	bool isLoaded() const { return m_flags == LOADED; }
 
+	/// Calls init() unless it was done ahead of the import
+	void initialize() {
+		if (m_flags == UNLOADED) {
+			init();
+			m_flags = INITIALIZED;
+		}
+	}
+
 	virtual void init() = 0;
 private:
 	std::string m_name;
 	ModuleMap m_mods;
+	ModuleFactoryMap m_factories;
 	VarMap m_vars;
 	ModuleStatus m_flags;
 	FunctionMap m_funcs;
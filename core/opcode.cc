@@ -10,7 +10,7 @@
 
 namespace clever {
 
-#ifdef CLEVER_DEBUG
+#if defined(CLEVER_DEBUG) || defined(CLEVER_OPCODE_STATS)
 const char* get_opcode_name(Opcode opnum)
 {
 	switch (opnum) {
@@ -65,6 +65,7 @@ const char* get_opcode_name(Opcode opnum)
 	case OP_BIND:        return "bind";
 	case OP_BSCOPE:      return "bscope";
 	case OP_ESCOPE:      return "escope";
+	case OP_NEW_LIT:     return "new_lit";
 	EMPTY_SWITCH_DEFAULT_CASE();
 	}
 #undef CASE
@@ -62,7 +62,8 @@ namespace clever {
 	&&OP_SUBSCRIPT_R,\
 	&&OP_BIND,     \
 	&&OP_BSCOPE,   \
-	&&OP_ESCOPE
+	&&OP_ESCOPE,   \
+	&&OP_NEW_LIT
 #endif
 
 /// VM opcodes
@@ -118,10 +119,11 @@ enum Opcode {
 	OP_BIND,       //       Used for runtime binding
 	OP_BSCOPE,     //       Used for begin scope marker
 	OP_ESCOPE,     //  50 - Used for end scope marker
+	OP_NEW_LIT,    //       Used for instantiating a constant array/map literal
 	NUM_OPCODES
 };
 
-#ifdef CLEVER_DEBUG
+#if defined(CLEVER_DEBUG) || defined(CLEVER_OPCODE_STATS)
 const char* get_opcode_name(Opcode);
 #endif
 
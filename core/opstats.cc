@@ -0,0 +1,173 @@
+/**
+ * Clever programming language
+ * Copyright (c) Clever Team
+ *
+ * This file is distributed under the MIT license. See LICENSE for details.
+ */
+
+#ifdef CLEVER_OPCODE_STATS
+
+#include <algorithm>
+#include <iomanip>
+#include <vector>
+#include "core/opstats.h"
+#include "modules/std/core/function.h"
+
+namespace clever {
+
+bool OpStats::s_enabled = false;
+bool OpStats::s_use_cycles = false;
+size_t OpStats::s_counts[NUM_OPCODES];
+size_t OpStats::s_operands[NUM_OPCODES][NUM_OPERAND_TYPES][NUM_OPERAND_TYPES];
+OpStats::cycles_t OpStats::s_cycles[NUM_OPCODES];
+size_t OpStats::s_histogram[NUM_OPCODES][NUM_BUCKETS];
+std::map<std::string, OpStats::FunctionCounts> OpStats::s_functions;
+
+THREAD_TLS const Function* OpStats::t_func = NULL;
+THREAD_TLS size_t* OpStats::t_func_counts = NULL;
+THREAD_TLS Opcode OpStats::t_last_op = NUM_OPCODES;
+THREAD_TLS OpStats::cycles_t OpStats::t_last_cycles = 0;
+
+// Number of rows printed for the operand and per function tables
+static const size_t MAX_ROWS = 20;
+
+typedef std::pair<size_t, size_t> CountRow; // (count, index)
+
+static const char* operand_name(size_t type)
+{
+	switch (type) {
+		case UNUSED:      return "-";
+		case FETCH_VAR:   return "var";
+		case FETCH_CONST: return "const";
+		case FETCH_TMP:   return "tmp";
+		case JMP_ADDR:    return "addr";
+		default:          return "?";
+	}
+}
+
+size_t* OpStats::getFunctionCounts(const Function* func)
+{
+	return s_functions[func ? func->getName() : "<main>"].counts;
+}
+
+void OpStats::chargeCycles(Opcode op, cycles_t cycles)
+{
+	size_t bucket = 0;
+
+	s_cycles[op] += cycles;
+
+	while (cycles >>= 1) {
+		++bucket;
+	}
+	++s_histogram[op][bucket];
+}
+
+void OpStats::dump(std::ostream& out)
+{
+	std::vector<CountRow> rows;
+	size_t total = 0;
+
+	for (size_t i = 0; i < NUM_OPCODES; ++i) {
+		if (s_counts[i]) {
+			rows.push_back(CountRow(s_counts[i], i));
+			total += s_counts[i];
+		}
+	}
+
+	std::sort(rows.rbegin(), rows.rend());
+
+	out << "Opcode dispatches: " << total << "\n"
+		<< std::left << std::setw(14) << "opcode" << std::right
+		<< std::setw(14) << "count" << std::setw(9) << "%";
+
+	if (s_use_cycles) {
+		out << std::setw(16) << "cycles" << std::setw(10) << "avg"
+			<< "  histogram (log2 cycles:count)";
+	}
+	out << "\n";
+
+	for (size_t i = 0, j = rows.size(); i < j; ++i) {
+		Opcode op = static_cast<Opcode>(rows[i].second);
+
+		out << std::left << std::setw(14) << get_opcode_name(op) << std::right
+			<< std::setw(14) << rows[i].first
+			<< std::setw(9) << std::fixed << std::setprecision(2)
+			<< 100.0 * rows[i].first / total;
+
+		if (s_use_cycles) {
+			out << std::setw(16) << s_cycles[op]
+				<< std::setw(10) << s_cycles[op] / rows[i].first << " ";
+
+			for (size_t b = 0; b < NUM_BUCKETS; ++b) {
+				if (s_histogram[op][b]) {
+					out << " " << b << ":" << s_histogram[op][b];
+				}
+			}
+		}
+		out << "\n";
+	}
+
+	// (opcode, op1, op2) triples
+	rows.clear();
+
+	for (size_t i = 0; i < NUM_OPCODES; ++i) {
+		for (size_t a = 0; a < NUM_OPERAND_TYPES; ++a) {
+			for (size_t b = 0; b < NUM_OPERAND_TYPES; ++b) {
+				if (s_operands[i][a][b]) {
+					rows.push_back(CountRow(s_operands[i][a][b],
+						(i * NUM_OPERAND_TYPES + a) * NUM_OPERAND_TYPES + b));
+				}
+			}
+		}
+	}
+
+	std::sort(rows.rbegin(), rows.rend());
+
+	out << "\n" << std::left << std::setw(28) << "opcode op1 op2" << std::right
+		<< std::setw(14) << "count" << "\n";
+
+	for (size_t i = 0, j = std::min(rows.size(), MAX_ROWS); i < j; ++i) {
+		size_t idx = rows[i].second;
+		std::string name = get_opcode_name(
+			static_cast<Opcode>(idx / (NUM_OPERAND_TYPES * NUM_OPERAND_TYPES)));
+
+		name += std::string(" ") + operand_name(idx / NUM_OPERAND_TYPES % NUM_OPERAND_TYPES);
+		name += std::string(" ") + operand_name(idx % NUM_OPERAND_TYPES);
+
+		out << std::left << std::setw(28) << name << std::right
+			<< std::setw(14) << rows[i].first << "\n";
+	}
+
+	// Hottest opcodes of each function
+	std::map<std::string, FunctionCounts>::const_iterator it(s_functions.begin()),
+		end(s_functions.end());
+
+	out << "\nPer function (top 5 opcodes)\n";
+
+	for (; it != end; ++it) {
+		size_t func_total = 0;
+
+		rows.clear();
+
+		for (size_t i = 0; i < NUM_OPCODES; ++i) {
+			if (it->second.counts[i]) {
+				rows.push_back(CountRow(it->second.counts[i], i));
+				func_total += it->second.counts[i];
+			}
+		}
+
+		std::sort(rows.rbegin(), rows.rend());
+
+		out << it->first << ": " << func_total << "\n";
+
+		for (size_t i = 0, j = std::min(rows.size(), size_t(5)); i < j; ++i) {
+			out << "  " << std::left << std::setw(12)
+				<< get_opcode_name(static_cast<Opcode>(rows[i].second))
+				<< std::right << std::setw(14) << rows[i].first << "\n";
+		}
+	}
+}
+
+} // clever
+
+#endif // CLEVER_OPCODE_STATS
@@ -0,0 +1,119 @@
+/**
+ * Clever programming language
+ * Copyright (c) Clever Team
+ *
+ * This file is distributed under the MIT license. See LICENSE for details.
+ */
+
+#ifndef CLEVER_OPSTATS_H
+#define CLEVER_OPSTATS_H
+
+#ifdef CLEVER_OPCODE_STATS
+
+#include <iostream>
+#include <map>
+#include <string>
+#include "core/clever.h"
+#include "core/ir.h"
+#include "core/opcode.h"
+
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+# include <x86intrin.h>
+#else
+# include <ctime>
+#endif
+
+namespace clever {
+
+class Function;
+
+/**
+ * @brief per-opcode dispatch counters for instrumented builds.
+ *
+ * Only available when built with -DENABLE_OPCODE_STATS=1, the VM calls
+ * dispatch() before jumping to each opcode handler. Opcodes are counted in
+ * total, per operand type pair and per running function. With cycles
+ * enabled, the time between two dispatches is charged to the first one and
+ * added to a log2 histogram. Counters are not atomic, so scripts running
+ * several threads get approximate numbers.
+ */
+class OpStats {
+public:
+	enum { NUM_OPERAND_TYPES = JMP_ADDR + 1, NUM_BUCKETS = 64 };
+
+	typedef unsigned long long cycles_t;
+
+	static void enable() { s_enabled = true; }
+	static bool isEnabled() { return s_enabled; }
+	static void enableCycles() { s_enabled = s_use_cycles = true; }
+
+	static CLEVER_FORCE_INLINE void dispatch(const IR& ir, const Function* func) {
+		if (EXPECTED(!s_enabled)) {
+			return;
+		}
+
+		++s_counts[ir.opcode];
+		++s_operands[ir.opcode][ir.op1.op_type][ir.op2.op_type];
+
+		if (UNEXPECTED(func != t_func || t_func_counts == NULL)) {
+			t_func = func;
+			t_func_counts = getFunctionCounts(func);
+		}
+		++t_func_counts[ir.opcode];
+
+		if (s_use_cycles) {
+			cycles_t now = readCycles();
+
+			if (t_last_op != NUM_OPCODES) {
+				chargeCycles(t_last_op, now - t_last_cycles);
+			}
+			t_last_op = ir.opcode;
+			t_last_cycles = now;
+		}
+	}
+
+	/// Writes the report, sorted by number of dispatches
+	static void dump(std::ostream& out);
+private:
+	struct FunctionCounts {
+		FunctionCounts() {
+			for (size_t i = 0; i < NUM_OPCODES; ++i) {
+				counts[i] = 0;
+			}
+		}
+
+		size_t counts[NUM_OPCODES];
+	};
+
+	static cycles_t readCycles() {
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+		return __rdtsc();
+#else
+		struct timespec ts;
+		clock_gettime(CLOCK_MONOTONIC, &ts);
+		return cycles_t(ts.tv_sec) * 1000000000ULL + ts.tv_nsec;
+#endif
+	}
+
+	static size_t* getFunctionCounts(const Function*);
+	static void chargeCycles(Opcode, cycles_t);
+
+	static bool s_enabled;
+	static bool s_use_cycles;
+	static size_t s_counts[NUM_OPCODES];
+	static size_t s_operands[NUM_OPCODES][NUM_OPERAND_TYPES][NUM_OPERAND_TYPES];
+	static cycles_t s_cycles[NUM_OPCODES];
+	static size_t s_histogram[NUM_OPCODES][NUM_BUCKETS];
+	static std::map<std::string, FunctionCounts> s_functions;
+
+	static THREAD_TLS const Function* t_func;
+	static THREAD_TLS size_t* t_func_counts;
+	static THREAD_TLS Opcode t_last_op;
+	static THREAD_TLS cycles_t t_last_cycles;
+};
+
+} // clever
+
+#endif // CLEVER_OPCODE_STATS
+
+#endif // CLEVER_OPSTATS_H
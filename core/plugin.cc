@@ -0,0 +1,110 @@
+/**
+ * Clever programming language
+ * Copyright (c) Clever Team
+ *
+ * This file is distributed under the MIT license. See LICENSE for details.
+ */
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+#if defined(CLEVER_SHARED_MODULES) && !defined(CLEVER_WIN32)
+# include <dlfcn.h>
+# include <unistd.h>
+#endif
+#include "core/plugin.h"
+#include "core/module.h"
+
+#ifndef CLEVER_MODULE_DIR
+# define CLEVER_MODULE_DIR "/usr/local/lib/clever"
+#endif
+
+namespace clever {
+
+#if defined(CLEVER_SHARED_MODULES) && !defined(CLEVER_WIN32)
+
+/// Returns the directories where the plugins are looked up, in order
+static std::vector<std::string> plugin_dirs()
+{
+	std::vector<std::string> dirs;
+	const char* path = getenv("CLEVER_MODULE_PATH");
+
+	if (path) {
+		std::string list(path);
+		size_t start = 0, end;
+
+		while ((end = list.find(':', start)) != std::string::npos) {
+			dirs.push_back(list.substr(start, end - start));
+			start = end + 1;
+		}
+		dirs.push_back(list.substr(start));
+	}
+
+	dirs.push_back(CLEVER_MODULE_DIR);
+
+	return dirs;
+}
+
+/// Opens a plugin library and checks it provides the module
+static Module* open_plugin(const std::string& path, const std::string& name)
+{
+	void* handle = dlopen(path.c_str(), RTLD_NOW | RTLD_LOCAL);
+
+	if (!handle) {
+		std::cerr << "Couldn't load the module `" << name << "': "
+			<< dlerror() << std::endl;
+		return NULL;
+	}
+
+	PluginEntry entry;
+
+	// Converting the object pointer is the documented way of using dlsym()
+	*reinterpret_cast<void**>(&entry) = dlsym(handle, CLEVER_PLUGIN_ENTRY);
+
+	const PluginInfo* info = entry ? entry() : NULL;
+
+	if (!info || info->api != CLEVER_PLUGIN_API || name != info->name) {
+		std::cerr << "The library " << path << " is not a plugin of the module `"
+			<< name << "' for this version of Clever" << std::endl;
+		dlclose(handle);
+		return NULL;
+	}
+
+	return info->create();
+}
+
+Module* Plugin::load(const std::string& name)
+{
+	std::string file(name);
+
+	std::replace(file.begin(), file.end(), '.', '_');
+	file += ".so";
+
+	std::vector<std::string> dirs(plugin_dirs());
+
+	for (size_t i = 0; i < dirs.size(); ++i) {
+		if (dirs[i].empty()) {
+			continue;
+		}
+
+		const std::string& path = dirs[i] + "/" + file;
+
+		if (access(path.c_str(), F_OK) == 0) {
+			return open_plugin(path, name);
+		}
+	}
+	return NULL;
+}
+
+#else
+
+Module* Plugin::load(const std::string&)
+{
+	// The runtime doesn't export its symbols to the plugins
+	return NULL;
+}
+
+#endif
+
+} // clever
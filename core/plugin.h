@@ -0,0 +1,85 @@
+/**
+ * Clever programming language
+ * Copyright (c) Clever Team
+ *
+ * This file is distributed under the MIT license. See LICENSE for details.
+ */
+
+#ifndef CLEVER_PLUGIN_H
+#define CLEVER_PLUGIN_H
+
+#include <string>
+#include "core/clever.h"
+
+namespace clever {
+
+class Module;
+
+/// Version of the plugin interface, to be bumped whenever the classes used
+/// by the modules (Module, Type, Value, ...) change their layout
+#define CLEVER_PLUGIN_API 1
+
+/// Name of the function returning the PluginInfo of a plugin
+#define CLEVER_PLUGIN_ENTRY "clever_plugin_info"
+
+/// Description of a module built as a plugin
+struct PluginInfo {
+	/// CLEVER_PLUGIN_API the plugin was built with
+	int api;
+
+	/// Name of the module, e.g. "db.sqlite3"
+	const char* name;
+
+	/// Creates an instance of the module
+	Module* (*create)();
+};
+
+typedef const PluginInfo* (*PluginEntry)();
+
+#ifdef __GNUC__
+# define CLEVER_PLUGIN_EXPORT __attribute__((visibility("default")))
+#else
+# define CLEVER_PLUGIN_EXPORT
+#endif
+
+/// Declares the entry point of a module when it is built as a plugin (the
+/// CLEVER_PLUGIN definition is set on its target), nothing otherwise
+#ifdef CLEVER_PLUGIN
+# define CLEVER_PLUGIN_MODULE(name, type)                                      \
+	extern "C" CLEVER_PLUGIN_EXPORT const ::clever::PluginInfo*                \
+	clever_plugin_info() {                                                     \
+		static const ::clever::PluginInfo info = {                             \
+			CLEVER_PLUGIN_API, name, ::clever::module_factory<type>            \
+		};                                                                     \
+		return &info;                                                          \
+	}
+#else
+# define CLEVER_PLUGIN_MODULE(name, type)
+#endif
+
+/**
+ * @brief loader of the modules built as shared objects.
+ *
+ * A module `a.b' is looked up as a_b.so in the directories listed in the
+ * CLEVER_MODULE_PATH environment variable (separated by ':'), then in the
+ * directory the plugins are installed to. Plugins resolve the symbols of the
+ * runtime from the executable, so they are only loaded by a runtime built
+ * with -DSHARED_MODULES=ON.
+ *
+ * Libraries are never unloaded: the module and its types are used until the
+ * interpreter shuts down, and other isolates may load the module again.
+ */
+class Plugin {
+public:
+	/// Loads the plugin of a module, returning a new instance of the module
+	/// or NULL if there is no such plugin
+	static Module* load(const std::string& name);
+private:
+	Plugin() {}
+
+	DISALLOW_COPY_AND_ASSIGN(Plugin);
+};
+
+} // clever
+
+#endif // CLEVER_PLUGIN_H
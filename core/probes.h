@@ -0,0 +1,44 @@
+/**
+ * Clever programming language
+ * Copyright (c) Clever Team
+ *
+ * This file is distributed under the MIT license. See LICENSE for details.
+ */
+
+#ifndef CLEVER_PROBES_H
+#define CLEVER_PROBES_H
+
+/**
+ * Static tracepoints (USDT) for perf, bpftrace and SystemTap
+ *
+ * When <sys/sdt.h> is found at configure time, each probe compiles to a
+ * single nop plus a note in the ELF file; tools patch the nop when they
+ * attach, so probes cost next to nothing while nobody is listening. Probe
+ * arguments must be cheap to compute, as they are evaluated either way.
+ *
+ * Provider `clever`:
+ *   function__entry(char* name, char* file, int line)
+ *   function__return(char* name, char* file, int line)
+ *   object__alloc(char* type, void* object)
+ *   object__free(char* type, void* object)
+ *   exception__throw(char* type, char* file, int line)
+ *   exception__catch(char* type, char* file, int line)
+ *   thread__start(char* entry, void* thread)
+ *   thread__join(char* entry, void* thread)
+ *   module__import(char* name)
+ *
+ * See extra/clever.bt for a sample bpftrace script.
+ */
+
+#ifdef HAVE_SYS_SDT_H
+# include <sys/sdt.h>
+# define CLEVER_PROBE1(name, a)          DTRACE_PROBE1(clever, name, a)
+# define CLEVER_PROBE2(name, a, b)       DTRACE_PROBE2(clever, name, a, b)
+# define CLEVER_PROBE3(name, a, b, c)    DTRACE_PROBE3(clever, name, a, b, c)
+#else
+# define CLEVER_PROBE1(name, a)
+# define CLEVER_PROBE2(name, a, b)
+# define CLEVER_PROBE3(name, a, b, c)
+#endif
+
+#endif // CLEVER_PROBES_H
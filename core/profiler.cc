@@ -0,0 +1,233 @@
+/**
+ * Clever programming language
+ * Copyright (c) Clever Team
+ *
+ * This file is distributed under the MIT license. See LICENSE for details.
+ */
+
+#include <algorithm>
+#include <iomanip>
+#include <set>
+#include <sstream>
+#include <vector>
+#ifndef CLEVER_WIN32
+# include <sys/time.h>
+#endif
+#include "core/profiler.h"
+#include "core/vm.h"
+#include "core/cthread.h"
+#include "core/location.hh"
+#include "modules/std/core/function.h"
+
+namespace clever {
+
+Profiler::StackMap Profiler::s_stacks;
+Profiler::CountMap Profiler::s_functions;
+Profiler::CountMap Profiler::s_lines;
+size_t Profiler::s_samples = 0;
+size_t Profiler::s_hz = 0;
+bool Profiler::s_running = false;
+volatile sig_atomic_t Profiler::s_pending = 0;
+
+// Guards the samples, as VMs on several threads may service the timer
+static CMutex g_profiler_mutex;
+
+typedef std::pair<std::string, std::pair<size_t, size_t> > TableRow;
+
+static bool sort_by_self(const TableRow& a, const TableRow& b)
+{
+	if (a.second.first != b.second.first) {
+		return a.second.first > b.second.first;
+	}
+	return a.second.second > b.second.second;
+}
+
+static std::string function_name(const Function* func)
+{
+	return func ? func->getName() : "<main>";
+}
+
+static std::string line_name(const location* loc)
+{
+	std::ostringstream out;
+
+	if (loc == NULL) {
+		return "<unknown>";
+	}
+
+	if (loc->begin.filename) {
+		out << *loc->begin.filename;
+	} else {
+		out << "<command line>";
+	}
+	out << ":" << loc->begin.line;
+
+	return out.str();
+}
+
+void Profiler::onSignal(int)
+{
+	s_pending = 1;
+	VM::interrupt();
+}
+
+bool Profiler::start(size_t hz)
+{
+#ifndef CLEVER_WIN32
+	if (hz == 0 || hz > 1000000) {
+		return false;
+	}
+
+	struct itimerval timer;
+
+	timer.it_interval.tv_sec = 0;
+	timer.it_interval.tv_usec = 1000000 / hz;
+	timer.it_value = timer.it_interval;
+
+	signal(SIGPROF, Profiler::onSignal);
+
+	if (setitimer(ITIMER_PROF, &timer, NULL) != 0) {
+		signal(SIGPROF, SIG_DFL);
+		return false;
+	}
+
+	s_hz = hz;
+	s_running = true;
+
+	return true;
+#else
+	return false;
+#endif
+}
+
+void Profiler::stop()
+{
+	if (!s_running) {
+		return;
+	}
+
+#ifndef CLEVER_WIN32
+	struct itimerval timer;
+
+	timer.it_interval.tv_sec = timer.it_interval.tv_usec = 0;
+	timer.it_value = timer.it_interval;
+
+	setitimer(ITIMER_PROF, &timer, NULL);
+	signal(SIGPROF, SIG_IGN);
+#endif
+	s_running = false;
+	s_pending = 0;
+}
+
+void Profiler::reset()
+{
+	g_profiler_mutex.lock();
+	s_stacks.clear();
+	s_functions.clear();
+	s_lines.clear();
+	s_samples = 0;
+	g_profiler_mutex.unlock();
+}
+
+/// Records the backtrace of the VM as a collapsed stack
+void Profiler::sample(const VM* vm)
+{
+	Backtrace frames;
+	std::set<std::string> seen_funcs, seen_lines;
+	std::string stack;
+
+	s_pending = 0;
+
+	vm->getBacktrace(frames);
+
+	if (frames.empty()) {
+		return;
+	}
+
+	g_profiler_mutex.lock();
+
+	++s_samples;
+
+	// Frames are innermost first, collapsed stacks go from the outermost
+	for (size_t i = frames.size(); i-- > 0;) {
+		const std::string func = function_name(frames[i].first);
+		const std::string line = line_name(frames[i].second);
+
+		if (!stack.empty()) {
+			stack += ';';
+		}
+		stack += func + " (" + line + ")";
+
+		if (seen_funcs.insert(func).second) {
+			++s_functions[func].total;
+		}
+		if (seen_lines.insert(line).second) {
+			++s_lines[line].total;
+		}
+	}
+
+	++s_stacks[stack];
+	++s_functions[function_name(frames[0].first)].self;
+	++s_lines[line_name(frames[0].second)].self;
+
+	g_profiler_mutex.unlock();
+}
+
+void Profiler::writeStacks(std::ostream& out)
+{
+	g_profiler_mutex.lock();
+
+	StackMap::const_iterator it(s_stacks.begin()), end(s_stacks.end());
+
+	for (; it != end; ++it) {
+		out << it->first << " " << it->second << "\n";
+	}
+
+	g_profiler_mutex.unlock();
+}
+
+void Profiler::writeTable(std::ostream& out, const char* title, const CountMap& counts)
+{
+	std::vector<TableRow> rows;
+	CountMap::const_iterator it(counts.begin()), end(counts.end());
+
+	for (; it != end; ++it) {
+		rows.push_back(TableRow(it->first,
+			std::make_pair(it->second.self, it->second.total)));
+	}
+
+	std::sort(rows.begin(), rows.end(), sort_by_self);
+
+	out << std::setw(8) << "self %" << std::setw(9) << "total %"
+		<< std::setw(10) << "samples" << "  " << title << "\n";
+
+	for (size_t i = 0, j = rows.size(); i < j; ++i) {
+		out << std::fixed << std::setprecision(2)
+			<< std::setw(8) << 100.0 * rows[i].second.first / s_samples
+			<< std::setw(9) << 100.0 * rows[i].second.second / s_samples
+			<< std::setw(10) << rows[i].second.first
+			<< "  " << rows[i].first << "\n";
+	}
+}
+
+void Profiler::writeReport(std::ostream& out)
+{
+	g_profiler_mutex.lock();
+
+	out << "Profile: " << s_samples << " samples";
+
+	if (s_hz) {
+		out << " at " << s_hz << " Hz";
+	}
+	out << "\n";
+
+	if (s_samples) {
+		writeTable(out, "function", s_functions);
+		out << "\n";
+		writeTable(out, "line", s_lines);
+	}
+
+	g_profiler_mutex.unlock();
+}
+
+} // clever
@@ -0,0 +1,85 @@
+/**
+ * Clever programming language
+ * Copyright (c) Clever Team
+ *
+ * This file is distributed under the MIT license. See LICENSE for details.
+ */
+
+#ifndef CLEVER_PROFILER_H
+#define CLEVER_PROFILER_H
+
+#include <csignal>
+#include <iostream>
+#include <map>
+#include <string>
+#include "core/clever.h"
+
+namespace clever {
+
+class VM;
+
+/**
+ * @brief statistical profiler for Clever code.
+ *
+ * A SIGPROF timer raises a flag that the VM services at its next safe point
+ * (a jump, a call or a return), where the backtrace of the running script is
+ * recorded. Nothing but the flag is touched from the signal handler, so the
+ * profiler is safe to leave running; the price is that time spent inside an
+ * internal function is charged to the next safe point of its caller.
+ *
+ * Samples are kept as collapsed stacks, the input format of flame graph
+ * tools, and as self/total counts per function and per line.
+ */
+class Profiler {
+public:
+	/// Starts sampling `hz` times per second of CPU time
+	static bool start(size_t hz = 100);
+
+	/// Stops sampling, keeping the samples taken so far
+	static void stop();
+
+	static bool isRunning() { return s_running; }
+
+	/// Drops the samples taken so far
+	static void reset();
+
+	/// Records a sample if the timer has fired
+	static void handlePending(const VM* vm) {
+		if (UNEXPECTED(s_pending)) {
+			sample(vm);
+		}
+	}
+
+	/// Writes the samples as collapsed stacks ("frame;frame;frame count")
+	static void writeStacks(std::ostream& out);
+
+	/// Writes the self/total table per function and per line
+	static void writeReport(std::ostream& out);
+private:
+	struct Counts {
+		Counts()
+			: self(0), total(0) {}
+
+		size_t self;
+		size_t total;
+	};
+
+	typedef std::map<std::string, size_t> StackMap;
+	typedef std::map<std::string, Counts> CountMap;
+
+	static void onSignal(int);
+	static void sample(const VM*);
+	static void writeTable(std::ostream&, const char*, const CountMap&);
+
+	static StackMap s_stacks;
+	static CountMap s_functions;
+	static CountMap s_lines;
+	static size_t s_samples;
+	static size_t s_hz;
+	static bool s_running;
+	static volatile sig_atomic_t s_pending;
+};
+
+} // clever
+
+#endif // CLEVER_PROFILER_H
@@ -0,0 +1,270 @@
+/**
+ * Clever programming language
+ * Copyright (c) Clever Team
+ *
+ * This file is distributed under the MIT license. See LICENSE for details.
+ */
+
+#include <cstring>
+#include <setjmp.h>
+#include "core/program.h"
+#include "core/cstring.h"
+#include "core/scope.h"
+#include "core/vm.h"
+#include "modules/std/core/function.h"
+
+namespace clever {
+
+// argv of the embedding processes, which never set it
+static int g_no_argc = 0;
+static char** g_no_argv = NULL;
+
+Program::Program()
+	: m_compiled(false)
+{
+	if (!g_clever_argc) {
+		g_clever_argc = &g_no_argc;
+		g_clever_argv = &g_no_argv;
+	}
+}
+
+bool Program::loadStr(const std::string& code, bool importStd)
+{
+	IsolateScope scope(&m_isolate);
+
+	if (m_compiled) {
+		return false;
+	}
+
+	jmp_buf saved;
+	bool loaded = false;
+
+	memcpy(saved, fatal_error, sizeof(jmp_buf));
+
+	if (setjmp(fatal_error) == 0) {
+		loaded = m_driver.loadStr(code, importStd) == 0;
+	} else {
+		loaded = false;
+	}
+
+	memcpy(fatal_error, saved, sizeof(jmp_buf));
+
+	return loaded && compile();
+}
+
+bool Program::loadFile(const std::string& file)
+{
+	IsolateScope scope(&m_isolate);
+
+	if (m_compiled) {
+		return false;
+	}
+
+	jmp_buf saved;
+	bool loaded = false;
+
+	memcpy(saved, fatal_error, sizeof(jmp_buf));
+
+	if (setjmp(fatal_error) == 0) {
+		loaded = m_driver.loadFile(file) == 0;
+	} else {
+		loaded = false;
+	}
+
+	memcpy(fatal_error, saved, sizeof(jmp_buf));
+
+	return loaded && compile();
+}
+
+/// Resolves the parsed script and generates its code
+bool Program::compile()
+{
+	jmp_buf saved;
+
+	memcpy(saved, fatal_error, sizeof(jmp_buf));
+
+	if (setjmp(fatal_error) == 0) {
+		m_driver.getCompiler().genCode();
+
+		m_compiled = m_driver.getCompiler().getGlobalEnv() != NULL;
+	}
+
+	memcpy(fatal_error, saved, sizeof(jmp_buf));
+
+	return m_compiled;
+}
+
+bool Program::getGlobalOffset(const std::string& name, ValueOffset& offset) const
+{
+	IsolateScope scope(&m_isolate);
+
+	if (!m_compiled) {
+		return false;
+	}
+
+	const Symbol* sym = m_driver.getCompiler().getGlobalScope()->getLocal(CSTRING(name));
+
+	if (!sym) {
+		return false;
+	}
+
+	offset = sym->voffset;
+	return true;
+}
+
+const Function* Program::getFunction(const std::string& name) const
+{
+	ValueOffset offset;
+
+	if (!getGlobalOffset(name, offset)) {
+		return NULL;
+	}
+
+	const Value* value = getGlobalEnv()->getValue(offset);
+
+	if (!value->isFunction()) {
+		return NULL;
+	}
+
+	return static_cast<const Function*>(value->getObj());
+}
+
+void Program::shutdown()
+{
+	IsolateScope scope(&m_isolate);
+
+	m_driver.getCompiler().shutdown();
+	m_compiled = false;
+}
+
+Context::Context(const Program* program)
+	: m_program(program), m_vm(NULL), m_globals(NULL)
+{
+	clever_assert(program->isCompiled(), "The program must be compiled");
+
+	init();
+}
+
+Context::~Context()
+{
+	clear();
+}
+
+void Context::init()
+{
+	IsolateScope scope(m_program->getIsolate());
+
+	m_globals = m_program->getGlobalEnv()->activate();
+
+	m_vm = new VM(m_program->getIR());
+	m_vm->setConstEnv(m_program->getConstEnv());
+	m_vm->setGlobalEnv(m_globals);
+	m_vm->setGlobalProto(m_program->getGlobalEnv());
+	m_vm->keepObjects();
+}
+
+void Context::clear()
+{
+	IsolateScope scope(m_program->getIsolate());
+
+	delete m_vm;
+	clever_delref(m_globals);
+
+	m_vm = NULL;
+	m_globals = NULL;
+}
+
+void Context::reset()
+{
+	clear();
+	init();
+}
+
+bool Context::run()
+{
+	IsolateScope scope(m_program->getIsolate());
+
+	const VM* prev_vm = VM::getCurrent();
+	jmp_buf saved;
+	bool ok = false;
+
+	memcpy(saved, fatal_error, sizeof(jmp_buf));
+
+	m_vm->resetState();
+
+	if (setjmp(fatal_error) == 0) {
+		m_vm->run();
+		ok = true;
+	} else {
+		ok = false;
+
+		// The VM was left in the middle of the code
+		VM::setCurrent(const_cast<VM*>(prev_vm));
+		reset();
+	}
+
+	memcpy(fatal_error, saved, sizeof(jmp_buf));
+
+	return ok;
+}
+
+Value* Context::call(const std::string& name, const ValueVector& args)
+{
+	const Function* func = m_program->getFunction(name);
+
+	return func ? call(func, args) : NULL;
+}
+
+Value* Context::call(const Function* func, const ValueVector& args)
+{
+	IsolateScope scope(m_program->getIsolate());
+
+	const VM* prev_vm = VM::getCurrent();
+	jmp_buf saved;
+	Value* result = NULL;
+
+	memcpy(saved, fatal_error, sizeof(jmp_buf));
+
+	if (setjmp(fatal_error) == 0) {
+		result = m_vm->runFunction(func, args);
+
+		// Only the objects still referenced (e.g. by the globals or by the
+		// result) outlive the call
+		m_vm->releaseUnreachableObjects();
+	} else {
+		result = NULL;
+
+		VM::setCurrent(const_cast<VM*>(prev_vm));
+		reset();
+	}
+
+	memcpy(fatal_error, saved, sizeof(jmp_buf));
+
+	return result;
+}
+
+Value* Context::getGlobal(const std::string& name) const
+{
+	ValueOffset offset;
+
+	if (!m_program->getGlobalOffset(name, offset)) {
+		return NULL;
+	}
+	return m_globals->getValue(offset);
+}
+
+bool Context::setGlobal(const std::string& name, const Value* value)
+{
+	IsolateScope scope(m_program->getIsolate());
+
+	Value* global = getGlobal(name);
+
+	if (!global) {
+		return false;
+	}
+
+	global->deepCopy(value);
+	return true;
+}
+
+} // clever
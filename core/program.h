@@ -0,0 +1,161 @@
+/**
+ * Clever programming language
+ * Copyright (c) Clever Team
+ *
+ * This file is distributed under the MIT license. See LICENSE for details.
+ */
+
+#ifndef CLEVER_PROGRAM_H
+#define CLEVER_PROGRAM_H
+
+#include <string>
+#include "core/driver.h"
+#include "core/isolate.h"
+#include "core/value.h"
+
+namespace clever {
+
+class Context;
+class Scope;
+class VM;
+
+/**
+ * @brief a script compiled once, to be run many times by Context instances.
+ *
+ * Embedding example:
+ *
+ *   clever::Program program;
+ *
+ *   if (!program.loadFile("handler.clv")) { ... }
+ *
+ *   // The values passed to and returned by the program have its types
+ *   clever::IsolateScope scope(program.getIsolate());
+ *
+ *   clever::Context ctx(&program);
+ *
+ *   ctx.run();                          // the main code, setting the globals
+ *
+ *   for (each request) {
+ *       clever::ValueVector args;
+ *       args.push_back(new clever::Value(42L));
+ *
+ *       clever::Value* result = ctx.call("handle", args);
+ *       ...
+ *       clever_delref(result);
+ *       std::for_each(args.begin(), args.end(), clever::clever_delref);
+ *
+ *       ctx.reset(); ctx.run();         // when a request must not see the
+ *   }                                   // globals left by the previous one
+ *
+ *   program.shutdown();
+ *
+ * The program is never changed once compiled: its instructions, constants
+ * and functions are shared by the contexts, each of them running the code
+ * with its own copy of the globals.
+ *
+ * Every program is compiled and run in an isolate of its own, so the
+ * contexts of different programs can run in parallel, one per thread.
+ */
+class Program {
+public:
+	Program();
+
+	~Program() {}
+
+	/// Compiles a script, returns false on errors, which are reported
+	/// on the standard error as usual
+	bool loadStr(const std::string& code, bool importStd = false);
+	bool loadFile(const std::string& file);
+
+	bool isCompiled() const { return m_compiled; }
+
+	/// Returns the user function declared in the global scope with this
+	/// name, NULL if there is none
+	const Function* getFunction(const std::string& name) const;
+
+	/// Returns the offset of a global variable, false if there is none
+	bool getGlobalOffset(const std::string& name, ValueOffset& offset) const;
+
+	const IRVector& getIR() const { return m_driver.getCompiler().getIR(); }
+	Environment* getConstEnv() const { return m_driver.getCompiler().getConstEnv(); }
+	Environment* getGlobalEnv() const { return m_driver.getCompiler().getGlobalEnv(); }
+
+	Isolate* getIsolate() const { return &m_isolate; }
+
+	/// Frees the program and the runtime, once all its contexts are gone
+	void shutdown();
+private:
+	class ProgramDriver : public Driver {
+	public:
+		ProgramDriver() {}
+
+		/// Programs are run by contexts
+		void execute(bool) {}
+	private:
+		DISALLOW_COPY_AND_ASSIGN(ProgramDriver);
+	};
+
+	bool compile();
+
+	mutable Isolate m_isolate;
+
+	mutable ProgramDriver m_driver;
+
+	bool m_compiled;
+
+	DISALLOW_COPY_AND_ASSIGN(Program);
+};
+
+/**
+ * @brief an execution context of a Program.
+ *
+ * A context owns a VM and a copy of the program globals. It can run the main
+ * code and call the program functions any number of times, keeping the
+ * globals between them until reset(). The objects and closures created by
+ * the code are kept while something references them: the unreachable ones
+ * are released after each call(), and all of them by reset().
+ *
+ * A fatal error (an uncaught exception, a runtime error) makes run() and
+ * call() fail and gives the context fresh globals.
+ *
+ * A context can be used from any thread, but by a single one at a time.
+ */
+class Context {
+public:
+	explicit Context(const Program* program);
+
+	~Context();
+
+	/// Runs the main code of the program, returns false on a fatal error
+	bool run();
+
+	/// Calls a global function of the program, returns its result to be
+	/// released by the caller, NULL if there is no such function or on a
+	/// fatal error
+	Value* call(const std::string& name, const ValueVector& args = ValueVector());
+	Value* call(const Function* func, const ValueVector& args = ValueVector());
+
+	/// Gives the context fresh globals, as if it was just created
+	void reset();
+
+	/// Returns a global variable, NULL if there is none
+	Value* getGlobal(const std::string& name) const;
+
+	/// Sets a global variable, returns false if there is none
+	bool setGlobal(const std::string& name, const Value* value);
+private:
+	void init();
+	void clear();
+
+	const Program* m_program;
+
+	VM* m_vm;
+
+	Environment* m_globals;
+
+	DISALLOW_COPY_AND_ASSIGN(Context);
+};
+
+} // clever
+
+#endif // CLEVER_PROGRAM_H
@@ -30,6 +30,21 @@ void Resolver::initGlobalScope()
 	m_mod = m_modmanager.getUserModule();
 }
 
+void Resolver::resume(Block* node)
+{
+	// A failed line may have been left in an inner scope
+	while (m_stack.size() > 1) {
+		m_stack.pop();
+	}
+	m_scope = m_symtable;
+	m_class = NULL;
+	m_func = NULL;
+
+	node->setScope(m_scope);
+
+	Visitor::visit(static_cast<NodeArray*>(node));
+}
+
 void Resolver::visit(Block* node)
 {
 	bool had_outer = m_scope != NULL;
@@ -287,7 +302,7 @@ void Resolver::visit(ClassDef* node)
 	UserType* type = new UserType(name);
 
 	m_mod->addType(type);
-	type->init();
+	type->initialize();
 
 	Value* tmp = new Value(type);
 	m_scope->pushValue(name, tmp);
@@ -28,6 +28,10 @@ public:
 
 	void initGlobalScope();
 
+	/// Resolves a new line of an interactive session in the global scope,
+	/// which keeps the declarations of the previous lines
+	void resume(Block*);
+
 	Scope* getSymTable() const { return m_symtable; }
 
 	Environment* getGlobalEnv() const {
@@ -73,17 +73,13 @@ ValueOffset Scope::getOffset(const Symbol* sym) const
 	const Environment* last_env = m_environment;
 
 	while (scope) {
-		SymbolMap::const_iterator it(scope->m_symbols.begin()),
-			end(scope->m_symbols.end());
-
 		if (scope->m_environment != last_env) {
 			offset.first++;
 		}
 
-		for (; it != end; ++it) {
-			if ((*it) == sym) {
-				goto finish;
-			}
+		// Symbols are owned by the scope they were declared in
+		if (scope == sym->scope) {
+			goto finish;
 		}
 
 		last_env = scope->m_environment;
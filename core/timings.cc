@@ -0,0 +1,110 @@
+/**
+ * Clever programming language
+ * Copyright (c) Clever Team
+ *
+ * This file is distributed under the MIT license. See LICENSE for details.
+ */
+
+#include <ctime>
+#include <iomanip>
+#include "core/timings.h"
+
+namespace clever {
+
+bool Timings::s_enabled = false;
+std::vector<Timings::Phase> Timings::s_phases;
+std::vector<size_t> Timings::s_open;
+
+Timings::nsecs_t Timings::now()
+{
+#ifndef CLEVER_WIN32
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return nsecs_t(ts.tv_sec) * 1000000000ULL + ts.tv_nsec;
+#else
+	LARGE_INTEGER freq, count;
+
+	QueryPerformanceFrequency(&freq);
+	QueryPerformanceCounter(&count);
+
+	return nsecs_t(count.QuadPart) * 1000000000ULL / freq.QuadPart;
+#endif
+}
+
+void Timings::begin(const std::string& name)
+{
+	s_open.push_back(s_phases.size());
+	s_phases.push_back(Phase(name, s_open.size() - 1));
+
+	Phase& phase = s_phases.back();
+
+	for (size_t i = 0; i < MemStats::NUM_KINDS; ++i) {
+		phase.allocs[i] = MemStats::get(static_cast<MemStats::Kind>(i)).allocs;
+	}
+	phase.start = now();
+}
+
+void Timings::end()
+{
+	nsecs_t end = now();
+
+	if (s_open.empty()) {
+		return;
+	}
+
+	Phase& phase = s_phases[s_open.back()];
+
+	s_open.pop_back();
+
+	phase.nsecs = end - phase.start;
+
+	for (size_t i = 0; i < MemStats::NUM_KINDS; ++i) {
+		phase.allocs[i] = MemStats::get(static_cast<MemStats::Kind>(i)).allocs
+			- phase.allocs[i];
+	}
+
+	if (!s_open.empty()) {
+		s_phases[s_open.back()].children += phase.nsecs;
+	}
+}
+
+void Timings::endAll()
+{
+	while (!s_open.empty()) {
+		end();
+	}
+}
+
+void Timings::dump(std::ostream& out)
+{
+	nsecs_t total = 0;
+
+	endAll();
+
+	out << "Timings\n"
+		<< std::right << std::setw(10) << "total ms" << std::setw(10) << "self ms"
+		<< std::setw(10) << "values" << std::setw(8) << "envs"
+		<< std::setw(8) << "objects" << "  phase\n";
+
+	for (size_t i = 0, j = s_phases.size(); i < j; ++i) {
+		const Phase& phase = s_phases[i];
+
+		if (phase.depth == 0) {
+			total += phase.nsecs;
+		}
+
+		out << std::fixed << std::setprecision(3)
+			<< std::setw(10) << phase.nsecs / 1e6
+			<< std::setw(10) << (phase.nsecs - phase.children) / 1e6
+			<< std::setw(10) << phase.allocs[MemStats::VALUE]
+			<< std::setw(8) << phase.allocs[MemStats::ENVIRONMENT]
+			<< std::setw(8) << phase.allocs[MemStats::OBJECT]
+			<< "  " << std::string(phase.depth * 2, ' ') << phase.name << "\n";
+	}
+
+	out << std::setw(10) << total / 1e6 << "  total\n";
+}
+
+} // clever
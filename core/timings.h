@@ -0,0 +1,104 @@
+/**
+ * Clever programming language
+ * Copyright (c) Clever Team
+ *
+ * This file is distributed under the MIT license. See LICENSE for details.
+ */
+
+#ifndef CLEVER_TIMINGS_H
+#define CLEVER_TIMINGS_H
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include "core/clever.h"
+#include "core/memstats.h"
+
+namespace clever {
+
+/**
+ * @brief wall time and allocations of the interpreter phases.
+ *
+ * Phases nest (a file imported by the resolver is parsed inside the
+ * resolver phase), so the report is a tree showing the inclusive and the
+ * self time of each phase, along with the number of Value, Environment and
+ * TypeObject instances allocated in it.
+ */
+class Timings {
+public:
+	static void enable() { s_enabled = true; }
+	static bool isEnabled() { return s_enabled; }
+
+	/// Starts a phase nested in the current one
+	static void begin(const std::string& name);
+
+	/// Ends the current phase
+	static void end();
+
+	/// Ends the phases left open by a fatal error
+	static void endAll();
+
+	/// Writes the phase tree
+	static void dump(std::ostream& out);
+private:
+	typedef unsigned long long nsecs_t;
+
+	struct Phase {
+		Phase(const std::string& name_, size_t depth_)
+			: name(name_), depth(depth_), start(0), nsecs(0), children(0) {
+			for (size_t i = 0; i < MemStats::NUM_KINDS; ++i) {
+				allocs[i] = 0;
+			}
+		}
+
+		std::string name;
+		size_t depth;
+		nsecs_t start;
+		nsecs_t nsecs;
+		nsecs_t children;
+		// Counters at the start of the phase, the difference after its end
+		size_t allocs[MemStats::NUM_KINDS];
+	};
+
+	static nsecs_t now();
+
+	static bool s_enabled;
+	static std::vector<Phase> s_phases;
+	static std::vector<size_t> s_open;
+};
+
+/// Times the enclosing block as a phase, when timings are enabled
+class TimingScope {
+public:
+	explicit TimingScope(const char* name)
+		: m_active(Timings::isEnabled()) {
+		if (UNEXPECTED(m_active)) {
+			Timings::begin(name);
+		}
+	}
+
+	TimingScope(const char* name, const std::string& detail)
+		: m_active(Timings::isEnabled()) {
+		if (UNEXPECTED(m_active)) {
+			Timings::begin(std::string(name) + " " + detail);
+		}
+	}
+
+	~TimingScope() { stop(); }
+
+	/// Ends the phase before the end of the block
+	void stop() {
+		if (UNEXPECTED(m_active)) {
+			Timings::end();
+			m_active = false;
+		}
+	}
+private:
+	bool m_active;
+
+	DISALLOW_COPY_AND_ASSIGN(TimingScope);
+};
+
+} // clever
+
+#endif // CLEVER_TIMINGS_H
@@ -0,0 +1,264 @@
+/**
+ * Clever programming language
+ * Copyright (c) Clever Team
+ *
+ * This file is distributed under the MIT license. See LICENSE for details.
+ */
+
+#include <ctime>
+#include <set>
+#include <sstream>
+#include "core/tracer.h"
+#include "core/cthread.h"
+#include "core/location.hh"
+#include "core/type.h"
+#include "modules/std/core/function.h"
+
+namespace clever {
+
+bool Tracer::s_enabled = false;
+Tracer::nsecs_t Tracer::s_start = 0;
+Tracer::nsecs_t Tracer::s_stop = 0;
+Tracer::nsecs_t Tracer::s_toplevel = 0;
+std::vector<Tracer::FuncInfo> Tracer::s_funcs;
+std::map<Tracer::FuncKey, size_t> Tracer::s_func_ids;
+std::map<std::string, size_t> Tracer::s_func_names;
+std::vector<Tracer::FrameStack*> Tracer::s_stacks;
+
+THREAD_TLS Tracer::FrameStack* Tracer::t_stack = NULL;
+
+// Guards the call graph, as VMs on several threads report their calls
+static CMutex g_tracer_mutex;
+
+// Id of the pseudo function which makes the top level calls
+static const size_t MAIN_ID = 0;
+
+static std::string file_name(const location* loc)
+{
+	if (loc == NULL) {
+		return "<internal>";
+	}
+	return loc->begin.filename ? *loc->begin.filename : "<command line>";
+}
+
+Tracer::nsecs_t Tracer::now()
+{
+#ifndef CLEVER_WIN32
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return nsecs_t(ts.tv_sec) * 1000000000ULL + ts.tv_nsec;
+#else
+	LARGE_INTEGER freq, count;
+
+	QueryPerformanceFrequency(&freq);
+	QueryPerformanceCounter(&count);
+
+	return nsecs_t(count.QuadPart) * 1000000000ULL / freq.QuadPart;
+#endif
+}
+
+void Tracer::clear()
+{
+	s_funcs.clear();
+	s_func_ids.clear();
+	s_func_names.clear();
+	s_toplevel = 0;
+
+	for (size_t i = 0, j = s_stacks.size(); i < j; ++i) {
+		s_stacks[i]->clear();
+	}
+
+	s_funcs.push_back(FuncInfo("<main>", "", 0));
+}
+
+void Tracer::start()
+{
+	g_tracer_mutex.lock();
+	clear();
+	s_start = now();
+	s_enabled = true;
+	g_tracer_mutex.unlock();
+}
+
+void Tracer::stop()
+{
+	if (!s_enabled) {
+		return;
+	}
+
+	g_tracer_mutex.lock();
+	s_stop = now();
+	s_enabled = false;
+	g_tracer_mutex.unlock();
+}
+
+/// Returns the id of the function, closures created from the same code
+/// share the id of their definition (the mutex must be held)
+size_t Tracer::getFuncId(const Function* func, const location* def)
+{
+	const FuncKey func_key(def, func->getName());
+	std::map<FuncKey, size_t>::const_iterator it = s_func_ids.find(func_key);
+
+	if (it != s_func_ids.end()) {
+		return it->second;
+	}
+
+	std::string name = func->getName();
+
+	if (func->hasContext()) {
+		name = func->getContext()->getName() + "::" + name;
+	}
+
+	const std::string file = file_name(def);
+	const size_t line = def ? def->begin.line : 0;
+
+	std::ostringstream key;
+	key << name << '@' << file << ':' << line;
+
+	std::map<std::string, size_t>::const_iterator found = s_func_names.find(key.str());
+	size_t id;
+
+	if (found != s_func_names.end()) {
+		id = found->second;
+	} else {
+		id = s_funcs.size();
+		s_funcs.push_back(FuncInfo(name, file, line));
+		s_func_names.insert(std::make_pair(key.str(), id));
+	}
+
+	s_func_ids.insert(std::make_pair(func_key, id));
+
+	return id;
+}
+
+/// Returns the call stack of the current thread (the mutex must be held)
+Tracer::FrameStack* Tracer::getStack()
+{
+	if (UNEXPECTED(t_stack == NULL)) {
+		t_stack = new FrameStack;
+		s_stacks.push_back(t_stack);
+	}
+	return t_stack;
+}
+
+void Tracer::enter(const Function* func, const location* site, const location* def)
+{
+	g_tracer_mutex.lock();
+
+	FrameStack* stack = getStack();
+
+	if (stack->empty() && s_funcs[MAIN_ID].file.empty()) {
+		s_funcs[MAIN_ID].file = file_name(site);
+	}
+
+	stack->push_back(Frame(getFuncId(func, def), site ? site->begin.line : 0, now()));
+
+	g_tracer_mutex.unlock();
+}
+
+void Tracer::leave()
+{
+	nsecs_t end = now();
+
+	g_tracer_mutex.lock();
+
+	FrameStack* stack = getStack();
+
+	// Calls started before the tracer have no frame
+	if (stack->empty()) {
+		g_tracer_mutex.unlock();
+		return;
+	}
+
+	const Frame frame = stack->back();
+	nsecs_t elapsed = end - frame.start;
+
+	stack->pop_back();
+
+	s_funcs[frame.func].self += elapsed - frame.children;
+
+	size_t caller = MAIN_ID;
+
+	if (stack->empty()) {
+		s_toplevel += elapsed;
+	} else {
+		stack->back().children += elapsed;
+		caller = stack->back().func;
+	}
+
+	Edge& edge = s_funcs[caller].calls[EdgeKey(frame.func, frame.line)];
+
+	++edge.count;
+	edge.inclusive += elapsed;
+
+	g_tracer_mutex.unlock();
+}
+
+void Tracer::write(std::ostream& out, const std::string& cmd)
+{
+	g_tracer_mutex.lock();
+
+	nsecs_t total = (s_enabled ? now() : s_stop) - s_start;
+	std::set<size_t> named_files, named_funcs;
+	std::map<std::string, size_t> file_ids;
+
+	// Whatever the top level calls did not take is main's own time
+	if (!s_funcs.empty()) {
+		s_funcs[MAIN_ID].self = total > s_toplevel ? total - s_toplevel : 0;
+	}
+
+	out << "# callgrind format\n"
+		<< "version: 1\n"
+		<< "creator: clever " CLEVER_VERSION_STRING "\n"
+		<< "cmd: " << cmd << "\n"
+		<< "positions: line\n"
+		<< "event: ns : Time (nanoseconds)\n"
+		<< "events: ns\n"
+		<< "summary: " << total << "\n";
+
+	for (size_t i = 0, j = s_funcs.size(); i < j; ++i) {
+		const FuncInfo& info = s_funcs[i];
+
+		if (i != MAIN_ID && info.self == 0 && info.calls.empty()) {
+			continue;
+		}
+
+		// Callgrind compresses names: "(id) name" the first time, "(id)" after
+		size_t fl = file_ids.insert(std::make_pair(info.file, file_ids.size() + 1)).first->second;
+
+		out << "\nfl=(" << fl << ")";
+		if (named_files.insert(fl).second) {
+			out << " " << info.file;
+		}
+		out << "\nfn=(" << i + 1 << ")";
+		if (named_funcs.insert(i).second) {
+			out << " " << info.name;
+		}
+		out << "\n" << info.line << " " << info.self << "\n";
+
+		EdgeMap::const_iterator it(info.calls.begin()), end(info.calls.end());
+
+		for (; it != end; ++it) {
+			const FuncInfo& callee = s_funcs[it->first.first];
+			size_t cfl = file_ids.insert(
+				std::make_pair(callee.file, file_ids.size() + 1)).first->second;
+
+			out << "cfl=(" << cfl << ")";
+			if (named_files.insert(cfl).second) {
+				out << " " << callee.file;
+			}
+			out << "\ncfn=(" << it->first.first + 1 << ")";
+			if (named_funcs.insert(it->first.first).second) {
+				out << " " << callee.name;
+			}
+			out << "\ncalls=" << it->second.count << " " << callee.line << "\n"
+				<< it->first.second << " " << it->second.inclusive << "\n";
+		}
+	}
+
+	g_tracer_mutex.unlock();
+}
+
+} // clever
@@ -0,0 +1,114 @@
+/**
+ * Clever programming language
+ * Copyright (c) Clever Team
+ *
+ * This file is distributed under the MIT license. See LICENSE for details.
+ */
+
+#ifndef CLEVER_TRACER_H
+#define CLEVER_TRACER_H
+
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+#include "core/clever.h"
+
+namespace clever {
+
+class Function;
+class location;
+
+/**
+ * @brief deterministic call-graph tracer.
+ *
+ * When enabled, the VM reports every user function entry and exit as well
+ * as every call to an internal function. The tracer keeps the exclusive time
+ * of each function and, for each caller/callee/call site edge, the number of
+ * calls and the inclusive time. The result is written in the callgrind
+ * format, which KCachegrind and similar tools read.
+ *
+ * Unlike the sampling profiler, every call is measured, so the counts are
+ * exact but the timer overhead inflates the cost of small functions.
+ */
+class Tracer {
+public:
+	typedef unsigned long long nsecs_t;
+
+	/// Starts tracing, dropping the data recorded so far
+	static void start();
+
+	/// Stops tracing, keeping the data recorded so far
+	static void stop();
+
+	static bool isEnabled() { return s_enabled; }
+
+	/// Records the start of a call to `func` from `site`; `def` is the first
+	/// instruction of user functions and NULL for internal ones
+	static void enter(const Function* func, const location* site, const location* def);
+
+	/// Records the end of the innermost call
+	static void leave();
+
+	/// Writes the recorded data in the callgrind format
+	static void write(std::ostream& out, const std::string& cmd);
+private:
+	struct Edge {
+		Edge()
+			: count(0), inclusive(0) {}
+
+		size_t count;
+		nsecs_t inclusive;
+	};
+
+	// (callee, call site line)
+	typedef std::pair<size_t, size_t> EdgeKey;
+	typedef std::map<EdgeKey, Edge> EdgeMap;
+
+	struct FuncInfo {
+		FuncInfo(const std::string& name_, const std::string& file_, size_t line_)
+			: name(name_), file(file_), line(line_), self(0) {}
+
+		std::string name;
+		std::string file;
+		size_t line;
+		nsecs_t self;
+		EdgeMap calls;
+	};
+
+	struct Frame {
+		Frame(size_t func_, size_t line_, nsecs_t start_)
+			: func(func_), line(line_), start(start_), children(0) {}
+
+		size_t func;
+		size_t line;
+		nsecs_t start;
+		nsecs_t children;
+	};
+
+	typedef std::vector<Frame> FrameStack;
+
+	/// A function by its definition and name, not by its address, which
+	/// is reused once a closure is freed
+	typedef std::pair<const location*, std::string> FuncKey;
+
+	static nsecs_t now();
+	static size_t getFuncId(const Function*, const location*);
+	static FrameStack* getStack();
+	static void clear();
+
+	static bool s_enabled;
+	static nsecs_t s_start;
+	static nsecs_t s_stop;
+	static nsecs_t s_toplevel;
+	static std::vector<FuncInfo> s_funcs;
+	static std::map<FuncKey, size_t> s_func_ids;
+	static std::map<std::string, size_t> s_func_names;
+	static std::vector<FrameStack*> s_stacks;
+
+	static THREAD_TLS FrameStack* t_stack;
+};
+
+} // clever
+
+#endif // CLEVER_TRACER_H
@@ -16,6 +16,16 @@ namespace clever {
 
 TypeObject::~TypeObject()
 {
+	MemStats::free(MemStats::OBJECT, m_counted);
+
+	if (m_counter) {
+		if (m_type_counted) {
+			m_counter->free();
+		}
+
+		CLEVER_PROBE2(object__free, m_counter->name, this);
+	}
+
 	MemberMap::const_iterator it(m_members.begin()), end(m_members.end());
 
 	for (; it != end; ++it) {
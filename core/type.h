@@ -17,6 +17,8 @@
 #include "core/refcounted.h"
 #include "core/clever.h"
 #include "core/cstring.h"
+#include "core/memstats.h"
+#include "core/probes.h"
 
 namespace clever {
 
@@ -80,7 +82,8 @@ typedef std::tr1::unordered_map<const CString*, Function*> MethodMap;
 class TypeObject : public RefCounted {
 public:
 	TypeObject()
-		: m_initialized(false) {}
+		: m_initialized(false), m_counted(MemStats::alloc(MemStats::OBJECT)),
+			m_type_counted(false), m_counter(NULL) {}
 
 	virtual ~TypeObject();
 
@@ -104,6 +107,24 @@ public:
 
 	virtual TypeObject* clone() const { return NULL; }
 
+	/// Attributes the object to its type's allocation counter, once;
+	/// returns whether the allocation was counted by this call
+	bool setCounter(MemCounter* counter) {
+		if (UNEXPECTED(m_counter == NULL) && counter) {
+			m_counter = counter;
+
+			if (UNEXPECTED(MemStats::isEnabled())) {
+				m_counter->alloc();
+				m_type_counted = true;
+			}
+
+			CLEVER_PROBE2(object__alloc, m_counter->name, this);
+
+			return m_type_counted;
+		}
+		return false;
+	}
+
 	void initialize(const Type* type) {
 		if (!m_initialized) {
 			copyMembers(type);
@@ -115,6 +136,14 @@ private:
 	/// Flag to indicate if the members were loaded into the instance
 	bool m_initialized;
 
+	/// Whether the object is counted by the memory statistics, as an
+	/// instance of TypeObject and of its type
+	bool m_counted;
+	bool m_type_counted;
+
+	/// Allocation counter of the type owning this object
+	MemCounter* m_counter;
+
 	DISALLOW_COPY_AND_ASSIGN(TypeObject);
 };
 
@@ -139,11 +168,12 @@ public:
 	enum TypeFlag { INTERNAL_TYPE, USER_TYPE };
 
 	Type()
-		: m_flags(INTERNAL_TYPE) {}
+		: m_flags(INTERNAL_TYPE), m_counter(NULL), m_initialized(false) {}
 
 	Type(const std::string& name, TypeFlag flags = INTERNAL_TYPE)
 		: m_name(name), m_ctor(NULL), m_dtor(NULL), m_user_ctor(NULL),
-			m_user_dtor(NULL), m_flags(flags) {}
+			m_user_dtor(NULL), m_flags(flags),
+			m_counter(MemStats::registerType(name)), m_initialized(false) {}
 
 	virtual ~Type() {}
 
@@ -192,6 +222,9 @@ public:
 	/// Method for retrieve the type name
 	const std::string& getName() const { return m_name; }
 
+	/// Allocation counter shared by the objects of this type
+	MemCounter* getCounter() const { return m_counter; }
+
 	void setConstructor(MethodPtr method);
 	void setDestructor(MethodPtr method);
 
@@ -207,6 +240,15 @@ public:
 	/// Virtual method for type initialization
 	virtual void init() {}
 
+	/// Builds the members on the first import of the type, later imports
+	/// (from other modules, files or namespaces) reuse them
+	void initialize() {
+		if (!m_initialized) {
+			m_initialized = true;
+			init();
+		}
+	}
+
 	/// Virtual method for debug purpose
 	virtual void dump(TypeObject* data) const { dump(data, std::cout); }
 	virtual void dump(TypeObject* data, std::ostream& out) const { out << toString(data); }
@@ -248,6 +290,8 @@ private:
 	const Function* m_user_ctor;
 	const Function* m_user_dtor;
 	TypeFlag m_flags;
+	MemCounter* m_counter;
+	bool m_initialized;
 
 	DISALLOW_COPY_AND_ASSIGN(Type);
 };
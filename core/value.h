@@ -12,27 +12,20 @@
 
 #include "core/cstring.h"
 #include "core/type.h"
+#include "core/memstats.h"
 #include "modules/std/core/str.h"
 
 namespace clever {
 
-extern Type* g_clever_int_type;
-extern Type* g_clever_double_type;
-extern Type* g_clever_str_type;
-extern Type* g_clever_func_type;
-extern Type* g_clever_bool_type;
-extern Type* g_clever_array_type;
-extern Type* g_clever_map_type;
-extern Type* g_clever_arrayiterator_type;
-
-#define CLEVER_INT_TYPE        g_clever_int_type
-#define CLEVER_DOUBLE_TYPE     g_clever_double_type
-#define CLEVER_STR_TYPE        g_clever_str_type
-#define CLEVER_FUNC_TYPE       g_clever_func_type
-#define CLEVER_BOOL_TYPE       g_clever_bool_type
-#define CLEVER_ARRAY_TYPE      g_clever_array_type
-#define CLEVER_MAP_TYPE        g_clever_map_type
-#define CLEVER_ARRAYITER_TYPE  g_clever_arrayiterator_type
+// Native types of the current isolate
+#define CLEVER_INT_TYPE        (clever::Isolate::getCurrent()->getTypes().int_type)
+#define CLEVER_DOUBLE_TYPE     (clever::Isolate::getCurrent()->getTypes().double_type)
+#define CLEVER_STR_TYPE        (clever::Isolate::getCurrent()->getTypes().str_type)
+#define CLEVER_FUNC_TYPE       (clever::Isolate::getCurrent()->getTypes().func_type)
+#define CLEVER_BOOL_TYPE       (clever::Isolate::getCurrent()->getTypes().bool_type)
+#define CLEVER_ARRAY_TYPE      (clever::Isolate::getCurrent()->getTypes().array_type)
+#define CLEVER_MAP_TYPE        (clever::Isolate::getCurrent()->getTypes().map_type)
+#define CLEVER_ARRAYITER_TYPE  (clever::Isolate::getCurrent()->getTypes().arrayiter_type)
 
 typedef std::map     <std::string, Value*>  ValueMap;
 typedef std::pair    <std::string, Value*>  ValuePair;
@@ -41,32 +34,39 @@ typedef std::vector  <Value*>               ValueVector;
 class Value : public RefCounted {
 public:
 	Value()
-		: m_type(NULL), m_data(NULL), m_is_const(false) {}
+		: m_type(NULL), m_data(NULL), m_is_const(false),
+			m_counted(MemStats::alloc(MemStats::VALUE)) {}
 
 	explicit Value(bool n, bool is_const = false)
-		: m_type(CLEVER_BOOL_TYPE), m_data(NULL), m_is_const(is_const) {
+		: m_type(CLEVER_BOOL_TYPE), m_data(NULL), m_is_const(is_const),
+			m_counted(MemStats::alloc(MemStats::VALUE)) {
 		setBool(n);
 	}
 
 	explicit Value(long n, bool is_const = false)
-		: m_type(CLEVER_INT_TYPE), m_data(NULL), m_is_const(is_const) {
+		: m_type(CLEVER_INT_TYPE), m_data(NULL), m_is_const(is_const),
+			m_counted(MemStats::alloc(MemStats::VALUE)) {
 		setInt(n);
 	}
 
 	explicit Value(double n, bool is_const = false)
-		: m_type(CLEVER_DOUBLE_TYPE), m_data(NULL), m_is_const(is_const) {
+		: m_type(CLEVER_DOUBLE_TYPE), m_data(NULL), m_is_const(is_const),
+			m_counted(MemStats::alloc(MemStats::VALUE)) {
 		setDouble(n);
 	}
 
 	explicit Value(const CString* value, bool is_const = false)
-		: m_type(CLEVER_STR_TYPE), m_data(NULL), m_is_const(is_const) {
+		: m_type(CLEVER_STR_TYPE), m_data(NULL), m_is_const(is_const),
+			m_counted(MemStats::alloc(MemStats::VALUE)) {
 		setObj(m_type, new StrObject(value));
 	}
 
 	explicit Value(const Type* type, bool is_const = false)
-		: m_type(type), m_data(NULL), m_is_const(is_const) {}
+		: m_type(type), m_data(NULL), m_is_const(is_const),
+			m_counted(MemStats::alloc(MemStats::VALUE)) {}
 
 	~Value() {
+		MemStats::free(MemStats::VALUE, m_counted);
 		clever_delref(m_data);
 	}
 
@@ -93,6 +93,11 @@ public:
 
 		m_type = type;
 		m_data = ptr;
+
+		if (UNEXPECTED(ptr->setCounter(type->getCounter()))
+			&& UNEXPECTED(MemStats::getSampleRate() != 0)) {
+			MemStats::sampleObject(type, ptr);
+		}
 	}
 	TypeObject* getObj() const { return  m_data; }
 
@@ -158,6 +163,7 @@ private:
 	const Type* m_type;
 	TypeObject* m_data;
 	bool m_is_const;
+	bool m_counted;
 
 	DISALLOW_COPY_AND_ASSIGN(Value);
 };
@@ -10,31 +10,79 @@
 #endif
 #include "core/opcode.h"
 #include "core/vm.h"
+#include "core/heapsnapshot.h"
+#include "core/metrics.h"
+#include "core/profiler.h"
+#include "core/opstats.h"
+#include "core/probes.h"
+#include "core/tracer.h"
 #include "core/value.h"
 #include "core/location.hh"
 #include "core/user.h"
 #include "core/type.h"
 #include "modules/std/core/function.h"
 #include "modules/std/core/array.h"
+#include "modules/std/core/map.h"
 
 #define OPCODE    m_inst[m_pc]
 
+#ifdef CLEVER_OPCODE_STATS
+# define OPSTATS     OpStats::dispatch(OPCODE, m_call_stack.top().func)
+#else
+# define OPSTATS
+#endif
+
 #if CLEVER_GCC_VERSION > 0 && !defined(CLEVER_NOGNU)
 # define OP(name)    name
-# define OPCODES     const static void* labels[] = { OP_LABELS }; goto *labels[m_inst[m_pc].opcode]
-# define DISPATCH    ++m_pc; goto *labels[m_inst[m_pc].opcode]
+# define OPCODES     const static void* labels[] = { OP_LABELS }; OPSTATS; goto *labels[m_inst[m_pc].opcode]
+# define DISPATCH    ++m_pc; OPSTATS; goto *labels[m_inst[m_pc].opcode]
 # define END_OPCODES
-# define VM_GOTO(n)  m_pc = n; goto *labels[m_inst[m_pc].opcode]
+# define VM_GOTO(n)  m_pc = n; OPSTATS; goto *labels[m_inst[m_pc].opcode]
 #else
 # define OP(name)    case name
-# define OPCODES     for (;;) { switch (m_inst[m_pc].opcode) {
+# define OPCODES     for (;;) { OPSTATS; switch (m_inst[m_pc].opcode) {
 # define DISPATCH    ++m_pc; break
 # define END_OPCODES EMPTY_SWITCH_DEFAULT_CASE(); } }
 # define VM_GOTO(n)  m_pc = n; break
 #endif
 
+#define VM_CHECK_INTERRUPT() \
+	if (UNEXPECTED(s_interrupt)) { handleInterrupt(); }
+
+#define TRACE_ENTER(func, def) \
+	if (UNEXPECTED(Tracer::isEnabled())) { Tracer::enter(func, &OPCODE.loc, def); }
+#define TRACE_LEAVE() \
+	if (UNEXPECTED(Tracer::isEnabled())) { Tracer::leave(); }
+
+#define NATIVE_ENTER(func) \
+	Metrics::nsecs_t native_start = Metrics::nativeEnter(); \
+	TRACE_ENTER(func, NULL)
+#define NATIVE_LEAVE() \
+	TRACE_LEAVE(); \
+	Metrics::nativeLeave(native_start)
+
+#define PROBE_FUNCTION(probe, func) \
+	CLEVER_PROBE3(probe, (func)->getName().c_str(), \
+		probe_file(m_inst[(func)->getAddr() - 1].loc), \
+		m_inst[(func)->getAddr() - 1].loc.begin.line)
+
 namespace clever {
 
+THREAD_TLS VM* VM::s_current = NULL;
+volatile sig_atomic_t VM::s_interrupt = 0;
+
+/// Returns the file name to be passed to the probes
+static inline const char* probe_file(const location& loc)
+{
+	return loc.begin.filename ? loc.begin.filename->c_str() : "";
+}
+
+/// Returns the type name of the exception to be passed to the probes
+static inline const char* probe_type(const Value* value)
+{
+	return value && value->getType() ? value->getType()->getName().c_str() : "";
+}
+
 /// Displays an error message
 void VM::error(const location& loc, const char* format, ...)
 {
@@ -89,6 +137,31 @@ void VM::dumpStackTrace(std::ostringstream& out)
 	} while (!m_call_stack.empty());
 }
 
+/// Collects the running location and the call sites of its callers
+void VM::getBacktrace(Backtrace& frames) const
+{
+	CallStack stack(m_call_stack);
+	const location* loc = m_pc < m_inst.size() ? &m_inst[m_pc].loc : NULL;
+
+	while (!stack.empty()) {
+		const CallStackEntry& entry = stack.top();
+
+		frames.push_back(StackFrame(entry.func, loc));
+
+		loc = entry.loc;
+		stack.pop();
+	}
+}
+
+/// Services the requests raised by signal handlers
+void VM::handleInterrupt() const
+{
+	s_interrupt = 0;
+
+	Profiler::handlePending(this);
+	HeapSnapshot::handlePending(this);
+}
+
 /// Fetchs the Environment according to the supplied operand type
 CLEVER_FORCE_INLINE Environment* VM::getCurrentEnvironment(OperandType type) const
 {
@@ -209,17 +282,98 @@ CLEVER_FORCE_INLINE void VM::paramBinding(const Function* func,
 	}
 }
 
+static void release_object(const StoredObject& obj)
+{
+	clever_delref(obj.env);
+	clever_delref(obj.owner);
+}
+
+// Releases the object stores left by the runs, when they were kept or
+// interrupted by a fatal error
+void VM::releaseObjects()
+{
+	while (!m_obj_store.empty()) {
+		std::for_each(m_obj_store.top().begin(), m_obj_store.top().end(), release_object);
+		m_obj_store.pop();
+	}
+	m_obj_checked = m_obj_full_check = 0;
+}
+
+CLEVER_FORCE_INLINE void VM::storeObject(Environment* env, TypeObject* owner, size_t refs)
+{
+	if (m_obj_store.empty()) {
+		m_obj_store.push(ObjectStore());
+	}
+
+	owner->addRef();
+	m_obj_store.top().push_back(StoredObject(env, owner, refs));
+}
+
+// Releases the kept objects whose owner has no reference left but the ones of
+// the store and of its environment. The objects stored since the last call
+// are always checked; all of them only once the store doubled since the last
+// full check, so that the work stays proportional to the objects created.
+// An object released by the full check can make an older one unreachable,
+// hence the repeated passes.
+void VM::releaseUnreachableObjects()
+{
+	if (m_obj_store.empty()) {
+		return;
+	}
+
+	ObjectStore& store = m_obj_store.top();
+	size_t start = store.size() >= 2 * m_obj_full_check ? 0 : m_obj_checked;
+	bool released = true;
+
+	while (released) {
+		size_t kept = start;
+
+		released = false;
+
+		for (size_t i = start, j = store.size(); i < j; ++i) {
+			if (store[i].owner->refCount() == store[i].refs) {
+				release_object(store[i]);
+				released = true;
+			} else {
+				store[kept++] = store[i];
+			}
+		}
+		store.erase(store.begin() + kept, store.end());
+	}
+
+	m_obj_checked = store.size();
+
+	if (start == 0) {
+		m_obj_full_check = store.size();
+	}
+}
+
+// Returns the outer environment for an activation of `env' made without an
+// explicit one: the running globals instead of the compile-time ones
+CLEVER_FORCE_INLINE Environment* VM::getActivationOuter(const Environment* env) const
+{
+	if (UNEXPECTED(m_global_proto != NULL) && env->getOuter() == m_global_proto) {
+		return m_global_env;
+	}
+	return NULL;
+}
+
 // Prepares an user function/method call
 CLEVER_FORCE_INLINE void VM::prepareCall(const Function* func, Environment* env)
 {
 	getMutex()->lock();
-	Environment* fenv = func->getEnvironment()->activate(env);
+	Environment* fenv = func->getEnvironment()->activate(
+		env ? env : getActivationOuter(func->getEnvironment()));
 
 	fenv->setRetAddr(m_pc + 1);
 	fenv->setRetVal(getValue(OPCODE.result));
 
 	m_call_stack.push(CallStackEntry(fenv, func, &OPCODE.loc));
 
+	TRACE_ENTER(func, &m_inst[func->getAddr() - 1].loc);
+	PROBE_FUNCTION(function__entry, func);
+	Metrics::userCall();
+
 	size_t args_count = m_call_args.size();
 
 	if (args_count < func->getNumRequiredArgs()
@@ -243,13 +397,11 @@ CLEVER_FORCE_INLINE void VM::createInstance(const Type* type, Value* instance)
 	const UserType* utype = static_cast<const UserType*>(type);
 	UserObject* uobj = static_cast<UserObject*>(instance->getObj());
 
-	uobj->setEnvironment(utype->getEnvironment()->activate());
+	uobj->setEnvironment(utype->getEnvironment()->activate(
+		getActivationOuter(utype->getEnvironment())));
 	uobj->getEnvironment()->getValue(ValueOffset(0,0))->copy(instance);
 
-	if (m_obj_store.empty()) {
-		m_obj_store.push(std::vector<Environment*>());
-	}
-	m_obj_store.top().push_back(uobj->getEnvironment());
+	storeObject(uobj->getEnvironment(), uobj, 2);
 }
 
 // Executes the supplied function
@@ -258,18 +410,27 @@ Value* VM::runFunction(const Function* func, const ValueVector& args)
 	Value* result = new Value;
 
 	if (UNEXPECTED(func->isInternal())) {
+		NATIVE_ENTER(func);
 		func->getFuncPtr()(result, args, &m_clever);
+		NATIVE_LEAVE();
 	} else {
-		Environment* fenv = func->getEnvironment()->activate();
+		Environment* fenv = func->getEnvironment()->activate(
+			getActivationOuter(func->getEnvironment()));
 		fenv->setRetVal(result);
 		fenv->setRetAddr(m_inst.size()-1);
 
 		m_call_stack.push(CallStackEntry(fenv, func, &OPCODE.loc));
 		m_call_args.clear();
 
+		TRACE_ENTER(func, &m_inst[func->getAddr() - 1].loc);
+		PROBE_FUNCTION(function__entry, func);
+		Metrics::userCall();
+
 		paramBinding(func, fenv, args);
 
-		m_obj_store.push(std::vector<Environment*>());
+		if (!m_keep_objects || m_obj_store.empty()) {
+			m_obj_store.push(ObjectStore());
+		}
 
 		size_t saved_pc = m_pc;
 		m_pc = func->getAddr();
@@ -378,6 +539,10 @@ bool VM::checkContext(const MemberData& mdata) const
 // the switch-based dispatching is used
 void VM::run()
 {
+	VM* prev_vm = s_current;
+
+	s_current = this;
+
 	getMutex()->lock();
 	if (m_call_stack.empty()) {
 		m_call_stack.push(CallStackEntry(m_global_env));
@@ -386,6 +551,7 @@ void VM::run()
 
 	OPCODES;
 	OP(OP_RET):
+	VM_CHECK_INTERRUPT();
 	if (EXPECTED(m_call_stack.top().env != m_global_env)) {
 		Environment* env = m_call_stack.top().env;
 		size_t ret_addr = env->getRetAddr();
@@ -405,11 +571,7 @@ void VM::run()
 					closure->setEnvironment(
 						func->getEnvironment()->activate(m_call_stack.top().env));
 
-					if (m_obj_store.empty()) {
-						m_obj_store.push(std::vector<Environment*>());
-					}
-
-					m_obj_store.top().push_back(closure->getEnvironment());
+					storeObject(closure->getEnvironment(), closure, 1);
 
 					goto out;
 				}
@@ -418,6 +580,8 @@ void VM::run()
 			m_call_stack.top().env->getRetVal()->copy(val);
 		}
 out:
+		TRACE_LEAVE();
+		PROBE_FUNCTION(function__return, m_call_stack.top().func);
 		clever_delref(env);
 		m_call_stack.pop();
 
@@ -467,9 +631,12 @@ out:
 	}
 	DISPATCH;
 
-	OP(OP_JMP): VM_GOTO(OPCODE.op1.jmp_addr);
+	OP(OP_JMP):
+	VM_CHECK_INTERRUPT();
+	VM_GOTO(OPCODE.op1.jmp_addr);
 
 	OP(OP_FCALL):
+	VM_CHECK_INTERRUPT();
 	{
 		const Value* fval = getValue(OPCODE.op1);
 
@@ -488,7 +655,9 @@ out:
 
 			VM_GOTO(func->getAddr());
 		} else {
+			NATIVE_ENTER(func);
 			func->getFuncPtr()(getValue(OPCODE.result), m_call_args, &m_clever);
+			NATIVE_LEAVE();
 			m_call_args.clear();
 
 			if (UNEXPECTED(m_exception.hasException())) {
@@ -504,6 +673,8 @@ out:
 		Environment* env = m_call_stack.top().env;
 		size_t ret_addr = env->getRetAddr();
 
+		TRACE_LEAVE();
+		PROBE_FUNCTION(function__return, m_call_stack.top().func);
 		clever_delref(env);
 		m_call_stack.pop();
 
@@ -685,7 +856,23 @@ out:
 	}
 	DISPATCH;
 
+	OP(OP_NEW_LIT):
+	{
+		const Value* literal = getValue(OPCODE.op1);
+		Value* instance = getValue(OPCODE.result);
+
+		if (literal->isArray()) {
+			instance->setObj(CLEVER_ARRAY_TYPE,
+				new ArrayObject(static_cast<const ArrayObject*>(literal->getObj())));
+		} else {
+			instance->setObj(CLEVER_MAP_TYPE,
+				new MapObject(static_cast<const MapObject*>(literal->getObj())));
+		}
+	}
+	DISPATCH;
+
 	OP(OP_MCALL):
+	VM_CHECK_INTERRUPT();
 	{
 		const Value* callee = getValue(OPCODE.op1);
 		const Value* method = getValue(OPCODE.op2);
@@ -738,12 +925,14 @@ out:
 
 			VM_GOTO(func->getAddr());
 		} else {
+			NATIVE_ENTER(func);
 			if (func->hasContext()) {
 				(type->*func->getMethodPtr())(getValue(OPCODE.result),
 					callee, m_call_args, &m_clever);
 			} else {
 				func->getFuncPtr()(getValue(OPCODE.result), m_call_args, &m_clever);
 			}
+			NATIVE_LEAVE();
 
 			m_call_args.clear();
 			if (UNEXPECTED(m_exception.hasException())) {
@@ -754,6 +943,7 @@ out:
 	DISPATCH;
 
 	OP(OP_SMCALL):
+	VM_CHECK_INTERRUPT();
 	{
 		const Value* valtype = getValue(OPCODE.op1);
 		const Type* type = valtype->getType();
@@ -778,8 +968,10 @@ out:
 
 				VM_GOTO(func->getAddr());
 			} else {
+				NATIVE_ENTER(func);
 				(type->*func->getMethodPtr())(getValue(OPCODE.result),
 					NULL, m_call_args, &m_clever);
+				NATIVE_LEAVE();
 
 				m_call_args.clear();
 
@@ -913,6 +1105,10 @@ out:
 	OP(OP_THROW): m_exception.setException(getValue(OPCODE.op1)); goto throw_exception;
 
 throw_exception:
+	Metrics::exceptionThrown();
+	CLEVER_PROBE3(exception__throw, probe_type(m_exception.getException()),
+		probe_file(OPCODE.loc), OPCODE.loc.begin.line);
+
 	if (EXPECTED(!m_try_stack.empty())) {
 		size_t catch_addr = m_try_stack.top().first;
 		if (m_try_stack.top().second > 1) {
@@ -922,6 +1118,9 @@ throw_exception:
 			}
 			catch_addr = m_try_stack.top().first;
 		}
+		CLEVER_PROBE3(exception__catch, probe_type(m_exception.getException()),
+			probe_file(m_inst[catch_addr].loc), m_inst[catch_addr].loc.begin.line);
+
 		getValue(m_inst[catch_addr].op1)->copy(m_exception.getException());
 		clever_delref(m_exception.getException());
 		m_exception.clear();
@@ -993,10 +1192,12 @@ throw_exception:
 exit_exception:
 	throwUncaughtException(OPCODE);
 exit:
-	if (!m_obj_store.empty()) {
-		std::for_each(m_obj_store.top().begin(), m_obj_store.top().end(), clever_delref);
+	if (!m_keep_objects && !m_obj_store.empty()) {
+		std::for_each(m_obj_store.top().begin(), m_obj_store.top().end(), release_object);
 		m_obj_store.pop();
 	}
+
+	s_current = prev_vm;
 }
 
 } // clever
@@ -8,6 +8,7 @@
 #ifndef CLEVER_VM_H
 #define CLEVER_VM_H
 
+#include <csignal>
 #include <stack>
 #include <vector>
 #include "core/ir.h"
@@ -21,6 +22,7 @@ namespace clever {
 class Function;
 class VM;
 class Environment;
+class TypeObject;
 class location;
 
 struct CallStackEntry {
@@ -35,15 +37,41 @@ struct CallStackEntry {
 
 typedef std::stack<CallStackEntry> CallStack;
 
+/// An environment created by the code for an object or a closure, which
+/// only keep a plain pointer to it. The object store owns the environment
+/// and a reference to its owner.
+struct StoredObject {
+	Environment* env;
+	TypeObject* owner;
+
+	/// References to the owner held by the store and by the environment
+	/// (`this'); the owner is unreachable when it has no other one
+	size_t refs;
+
+	StoredObject(Environment* env_, TypeObject* owner_, size_t refs_)
+		: env(env_), owner(owner_), refs(refs_) {}
+};
+
+typedef std::vector<StoredObject> ObjectStore;
+
+/// A frame of a backtrace: the running function (NULL for the main code) and
+/// the location being executed in it
+typedef std::pair<const Function*, const location*> StackFrame;
+typedef std::vector<StackFrame> Backtrace;
+
 /// VM representation
 class VM {
 public:
 	VM()
-		: m_pc(0), m_const_env(NULL), m_global_env(NULL), m_mutex(NULL), m_main(true),
+		: m_pc(0), m_const_env(NULL), m_global_env(NULL), m_global_proto(NULL),
+			m_mutex(NULL), m_main(true), m_keep_objects(false),
+			m_obj_checked(0), m_obj_full_check(0),
 			m_clever(this, &m_exception) {}
 
 	explicit VM(const IRVector& inst)
-		: m_pc(0), m_const_env(NULL), m_global_env(NULL), m_mutex(NULL), m_main(true),
+		: m_pc(0), m_const_env(NULL), m_global_env(NULL), m_global_proto(NULL),
+			m_mutex(NULL), m_main(true), m_keep_objects(false),
+			m_obj_checked(0), m_obj_full_check(0),
 			m_clever(this, &m_exception) {
 		m_inst.resize(inst.size());
 		std::copy(inst.begin(), inst.end(), m_inst.begin());
@@ -53,21 +81,61 @@ public:
 		: m_clever(this, &m_exception) {
 		m_mutex      = vm.m_mutex;
 		m_main       = false;
+		m_keep_objects = false;
+		m_obj_checked = m_obj_full_check = 0;
 		m_pc         = vm.m_pc;
 		m_inst       = vm.m_inst;
 		m_try_stack  = vm.m_try_stack;
 		m_global_env = vm.m_global_env;
+		m_global_proto = vm.m_global_proto;
 		m_call_stack = vm.m_call_stack;
 		m_const_env  = vm.m_const_env;
 	}
 
 	~VM() {
+		releaseObjects();
+
 		if (m_main && m_mutex) {
 			delete m_mutex;
 		}
+		if (s_current == this) {
+			s_current = NULL;
+		}
+	}
+
+	/// Returns the VM executing code on the current thread, if any
+	static const VM* getCurrent() { return s_current; }
+	static void setCurrent(VM* vm) { s_current = vm; }
+
+	/// Returns the location being executed, NULL when outside of the code
+	const location* getLocation() const {
+		return m_pc < m_inst.size() ? &m_inst[m_pc].loc : NULL;
+	}
+
+	/// Returns the function being executed, NULL at the top level
+	const Function* getFunction() const {
+		return m_call_stack.empty() ? NULL : m_call_stack.top().func;
+	}
+
+	/// Collects the running location and its callers, innermost first
+	void getBacktrace(Backtrace&) const;
+
+	/// Asks the running VMs to service a pending signal at the next jump,
+	/// call or return (safe to call from a signal handler)
+	static void interrupt() { s_interrupt = 1; }
+
+	/// Appends the instructions added to the code since they were given to
+	/// the VM, as the code of an interactive session grows line by line
+	void extend(const IRVector& inst) {
+		m_inst.insert(m_inst.end(), inst.begin() + m_inst.size(), inst.end());
 	}
 
 	void setGlobalEnv(Environment* globals) { m_global_env = globals; }
+
+	/// Sets the globals the code was compiled against when running it with
+	/// an activated copy of them, so that the functions and objects created
+	/// by the code see the copy instead
+	void setGlobalProto(Environment* proto) { m_global_proto = proto; }
 	void setConstEnv(Environment* consts) { m_const_env = consts; }
 
 	void setChild() { m_main = false; }
@@ -78,9 +146,34 @@ public:
 	size_t getPC() const { return m_pc; }
 	void nextPC() { ++m_pc; }
 
+	/// Keeps the objects and closures created by the code alive until the VM
+	/// is destroyed, instead of releasing them when run() or runFunction()
+	/// return, for globals outliving a run
+	void keepObjects() { m_keep_objects = true; }
+
+	/// Releases the kept objects and closures which are no longer reachable,
+	/// between two runs
+	void releaseUnreachableObjects();
+
+	/// Drops the frames and the exception left by a finished or failed run,
+	/// before running the code again
+	void resetState() {
+		m_pc = 0;
+		m_call_stack = CallStack();
+		m_call_args.clear();
+		m_try_stack = std::stack<std::pair<size_t, size_t> >();
+
+		// Left by an uncaught exception
+		if (m_exception.hasException()) {
+			clever_delref(m_exception.getException());
+			m_exception.clear();
+		}
+	}
+
 	CMutex* getMutex() {
 		if (!m_mutex) {
 			m_mutex = new CMutex;
+			m_mutex->setName("VM");
 		}
 		return m_mutex;
 	}
@@ -111,6 +204,15 @@ private:
 	/// Helper to change a value pointer on environment
 	void setValue(const Operand&, Value*, bool = true) const;
 
+	/// Releases the environments of the objects and closures created so far
+	void releaseObjects();
+
+	/// Adds an environment to the object store
+	void storeObject(Environment*, TypeObject*, size_t);
+
+	/// Helper to redirect the activations of the compile-time globals
+	Environment* getActivationOuter(const Environment*) const;
+
 	/// Helper to prepare a function/method call
 	void prepareCall(const Function*, Environment* = NULL);
 
@@ -120,6 +222,9 @@ private:
 	/// Helper to create a new instance
 	void createInstance(const Type*, Value*);
 
+	/// Services the requests raised by signal handlers
+	void handleInterrupt() const;
+
 	/// Helper for common operations
 	void binOp(const IR&);
 	void logicOp(const IR&);
@@ -143,6 +248,9 @@ private:
 	/// Globals
 	Environment* m_global_env;
 
+	/// Compile-time globals, when m_global_env is a copy of them
+	Environment* m_global_proto;
+
 	/// Call arguments
 	ValueVector m_call_args;
 
@@ -156,13 +264,28 @@ private:
 	std::stack<std::pair<size_t, size_t> > m_try_stack;
 
 	/// User object instance vector
-	std::stack<std::vector<Environment*> > m_obj_store;
+	std::stack<ObjectStore> m_obj_store;
 
 	CMutex* m_mutex;
 
 	bool m_main;
 
+	bool m_keep_objects;
+
+	/// Kept objects checked by the last releaseUnreachableObjects() call,
+	/// and by the last one which checked all of them
+	size_t m_obj_checked;
+	size_t m_obj_full_check;
+
 	Clever m_clever;
+
+	/// VM running on the current thread
+	static THREAD_TLS VM* s_current;
+
+	/// Set by signal handlers that need the VM to stop at a safe point
+	static volatile sig_atomic_t s_interrupt;
+
+	friend class HeapSnapshot;
 };
 
 } // clever
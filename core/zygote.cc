@@ -0,0 +1,212 @@
+/**
+ * Clever programming language
+ * Copyright (c) Clever Team
+ *
+ * This file is distributed under the MIT license. See LICENSE for details.
+ */
+
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <iostream>
+#ifndef CLEVER_WIN32
+# include <fcntl.h>
+# include <sys/stat.h>
+# include <sys/un.h>
+# include <sys/wait.h>
+#endif
+#include "core/driver.h"
+#include "core/zygote.h"
+
+#ifndef CLEVER_WIN32
+extern char** environ;
+#endif
+
+namespace clever {
+
+#ifndef CLEVER_WIN32
+
+/// Copies the strings to a NULL-terminated array, which is never freed as
+/// it becomes the arguments or the environment of the process
+static char** to_array(const std::vector<std::string>& list)
+{
+	char** array = new char*[list.size() + 1];
+
+	for (size_t i = 0; i < list.size(); ++i) {
+		array[i] = strdup(list[i].c_str());
+	}
+	array[list.size()] = NULL;
+
+	return array;
+}
+
+/// Makes the received descriptors the stdin, stdout and stderr
+static void redirect_stdio(int* fds)
+{
+	// Moved out of the way first, any of them could be 0, 1 or 2
+	for (int i = 0; i < ZygoteChannel::NUM_FDS; ++i) {
+		int fd = fcntl(fds[i], F_DUPFD, ZygoteChannel::NUM_FDS);
+
+		close(fds[i]);
+		fds[i] = fd;
+	}
+	for (int i = 0; i < ZygoteChannel::NUM_FDS; ++i) {
+		dup2(fds[i], i);
+		close(fds[i]);
+	}
+}
+
+/// Serves a request in the process forked for it: forks the process running
+/// the script and sends its status to the client. Only returns in the former.
+static void serve_request(const ZygoteChannel& conn, int* argc, char*** argv)
+{
+	int fds[ZygoteChannel::NUM_FDS];
+	std::string cwd;
+	std::vector<std::string> args, env;
+
+	if (!conn.recvFds(fds)) {
+		_exit(1);
+	}
+
+	if (!conn.readStr(cwd) || !conn.readList(args) || !conn.readList(env)
+		|| args.empty()) {
+		_exit(1);
+	}
+
+	pid_t pid = fork();
+
+	if (pid == 0) {
+		close(conn.getFd());
+		redirect_stdio(fds);
+
+		signal(SIGPIPE, SIG_DFL);
+
+		if (chdir(cwd.c_str()) != 0) {
+			std::cerr << "Couldn't change to the directory " << cwd << std::endl;
+			exit(1);
+		}
+
+		environ = to_array(env);
+
+		// std.math seeded rand() when the server initialized it
+		srand(static_cast<unsigned>(time(NULL)) ^ static_cast<unsigned>(getpid()));
+
+		*argc = static_cast<int>(args.size());
+		*argv = to_array(args);
+		return;
+	}
+
+	for (int i = 0; i < ZygoteChannel::NUM_FDS; ++i) {
+		close(fds[i]);
+	}
+
+	if (pid < 0 || !conn.writeInt(pid)) {
+		_exit(1);
+	}
+
+	int status = 0;
+
+	while (waitpid(pid, &status, 0) < 0) {
+		if (errno != EINTR) {
+			_exit(1);
+		}
+	}
+
+	conn.writeInt(status);
+	_exit(0);
+}
+
+bool Zygote::serve(Interpreter& interp, const char* path, int* argc, char*** argv)
+{
+	struct sockaddr_un addr;
+
+	if (strlen(path) >= sizeof(addr.sun_path)) {
+		std::cerr << "The socket path " << path << " is too long" << std::endl;
+		return false;
+	}
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	strcpy(addr.sun_path, path);
+
+	int sock = socket(AF_UNIX, SOCK_STREAM, 0);
+
+	if (sock < 0) {
+		perror("socket");
+		return false;
+	}
+
+	struct stat st;
+
+	// Only a socket left by a previous server is replaced
+	if (lstat(path, &st) == 0) {
+		if (!S_ISSOCK(st.st_mode)) {
+			std::cerr << path << " exists and is not a socket" << std::endl;
+			close(sock);
+			return false;
+		}
+		unlink(path);
+	}
+
+	// The scripts would run as our user, so no one else may connect
+	mode_t mask = umask(077);
+	int bound = bind(sock, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr));
+
+	umask(mask);
+
+	if (bound < 0 || listen(sock, SOMAXCONN) < 0) {
+		perror(path);
+		close(sock);
+		return false;
+	}
+
+	// Done once for all the scripts: the std modules are created, their
+	// plugins loaded and their types initialized before any fork
+	interp.getCompiler().preload();
+	interp.getCompiler().preloadModule("std");
+
+	// The request processes are reaped by the system
+	signal(SIGCHLD, SIG_IGN);
+	signal(SIGPIPE, SIG_IGN);
+
+	while (true) {
+		int conn = accept(sock, NULL, NULL);
+
+		if (conn < 0) {
+			if (errno == EINTR || errno == ECONNABORTED) {
+				continue;
+			}
+			perror("accept");
+			close(sock);
+			return false;
+		}
+
+		pid_t pid = fork();
+
+		if (pid == 0) {
+			close(sock);
+
+			// Waits for the process running the script
+			signal(SIGCHLD, SIG_DFL);
+
+			serve_request(ZygoteChannel(conn), argc, argv);
+			return true;
+		}
+
+		// On failures the client just sees the connection closed
+		close(conn);
+	}
+}
+
+#else
+
+bool Zygote::serve(Interpreter&, const char*, int*, char***)
+{
+	std::cerr << "The script server is not supported on this platform" << std::endl;
+	return false;
+}
+
+#endif
+
+} // clever
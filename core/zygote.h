@@ -0,0 +1,226 @@
+/**
+ * Clever programming language
+ * Copyright (c) Clever Team
+ *
+ * This file is distributed under the MIT license. See LICENSE for details.
+ */
+
+#ifndef CLEVER_ZYGOTE_H
+#define CLEVER_ZYGOTE_H
+
+#include <string>
+#include <vector>
+#ifndef CLEVER_WIN32
+# include <cerrno>
+# include <cstring>
+# include <sys/socket.h>
+# include <sys/types.h>
+# include <unistd.h>
+#endif
+#include "core/clever.h"
+
+namespace clever {
+
+class Interpreter;
+
+#ifndef CLEVER_WIN32
+
+/**
+ * @brief the framing of the requests sent to the script server.
+ *
+ * A request is a connection carrying the client's stdin, stdout and stderr
+ * (as SCM_RIGHTS ancillary data of a single byte), followed by the working
+ * directory, the arguments and the environment, each list preceded by its
+ * count. The server answers with the pid of the process running the script
+ * and, once it ends, its wait status.
+ *
+ * Numbers are 32-bit integers in host order, strings are preceded by their
+ * length. The methods are inline so the client needs none of the runtime.
+ */
+class ZygoteChannel {
+public:
+	static const int NUM_FDS = 3;
+
+	explicit ZygoteChannel(int fd)
+		: m_fd(fd) {}
+
+	~ZygoteChannel() {}
+
+	int getFd() const { return m_fd; }
+
+	bool sendFds(const int* fds) const {
+		char byte = 0;
+		char control[CMSG_SPACE(sizeof(int) * NUM_FDS)];
+		struct iovec iov;
+		struct msghdr msg;
+
+		iov.iov_base = &byte;
+		iov.iov_len = 1;
+
+		memset(&msg, 0, sizeof(msg));
+		memset(control, 0, sizeof(control));
+		msg.msg_iov = &iov;
+		msg.msg_iovlen = 1;
+		msg.msg_control = control;
+		msg.msg_controllen = sizeof(control);
+
+		struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+
+		cmsg->cmsg_level = SOL_SOCKET;
+		cmsg->cmsg_type = SCM_RIGHTS;
+		cmsg->cmsg_len = CMSG_LEN(sizeof(int) * NUM_FDS);
+		memcpy(CMSG_DATA(cmsg), fds, sizeof(int) * NUM_FDS);
+
+		return sendmsg(m_fd, &msg, 0) == 1;
+	}
+
+	bool recvFds(int* fds) const {
+		char byte;
+		char control[CMSG_SPACE(sizeof(int) * NUM_FDS)];
+		struct iovec iov;
+		struct msghdr msg;
+
+		iov.iov_base = &byte;
+		iov.iov_len = 1;
+
+		memset(&msg, 0, sizeof(msg));
+		msg.msg_iov = &iov;
+		msg.msg_iovlen = 1;
+		msg.msg_control = control;
+		msg.msg_controllen = sizeof(control);
+
+		if (recvmsg(m_fd, &msg, 0) != 1) {
+			return false;
+		}
+
+		struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+
+		if (!cmsg || cmsg->cmsg_type != SCM_RIGHTS
+			|| cmsg->cmsg_len != CMSG_LEN(sizeof(int) * NUM_FDS)) {
+			return false;
+		}
+		memcpy(fds, CMSG_DATA(cmsg), sizeof(int) * NUM_FDS);
+		return true;
+	}
+
+	bool writeInt(int value) const {
+		return writeAll(&value, sizeof(value));
+	}
+
+	bool readInt(int& value) const {
+		return readAll(&value, sizeof(value));
+	}
+
+	bool writeStr(const std::string& str) const {
+		return writeInt(static_cast<int>(str.size()))
+			&& writeAll(str.data(), str.size());
+	}
+
+	bool readStr(std::string& str) const {
+		int size;
+
+		if (!readInt(size) || size < 0) {
+			return false;
+		}
+		str.resize(size);
+		return size == 0 || readAll(&str[0], size);
+	}
+
+	bool writeList(const std::vector<std::string>& list) const {
+		if (!writeInt(static_cast<int>(list.size()))) {
+			return false;
+		}
+		for (size_t i = 0; i < list.size(); ++i) {
+			if (!writeStr(list[i])) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	bool readList(std::vector<std::string>& list) const {
+		int size;
+
+		if (!readInt(size) || size < 0) {
+			return false;
+		}
+		list.resize(size);
+
+		for (int i = 0; i < size; ++i) {
+			if (!readStr(list[i])) {
+				return false;
+			}
+		}
+		return true;
+	}
+private:
+	bool writeAll(const void* data, size_t size) const {
+		const char* ptr = static_cast<const char*>(data);
+
+		while (size > 0) {
+			ssize_t written = write(m_fd, ptr, size);
+
+			if (written < 0 && errno == EINTR) {
+				continue;
+			}
+			if (written <= 0) {
+				return false;
+			}
+			ptr += written;
+			size -= written;
+		}
+		return true;
+	}
+
+	bool readAll(void* data, size_t size) const {
+		char* ptr = static_cast<char*>(data);
+
+		while (size > 0) {
+			ssize_t nread = read(m_fd, ptr, size);
+
+			if (nread < 0 && errno == EINTR) {
+				continue;
+			}
+			if (nread <= 0) {
+				return false;
+			}
+			ptr += nread;
+			size -= nread;
+		}
+		return true;
+	}
+
+	int m_fd;
+};
+
+#endif
+
+/**
+ * @brief a script server, forking the processes that run the scripts from
+ * a runtime initialized once.
+ *
+ * `clever --server <socket>' creates and initializes the std modules, then
+ * waits for requests on the Unix socket, sent by clever-client. Each request
+ * is served by a forked process, which forks again to run the script: the
+ * first one waits for the second and sends its exit status back to the
+ * client, while the second one returns from serve() with the arguments of
+ * the client, to be handled exactly like the ones of a `clever' run.
+ *
+ * The script runs with the client's stdin, stdout, stderr, working
+ * directory and environment, but as the user of the server and without its
+ * controlling terminal. The socket is only accessible to that user.
+ */
+class Zygote {
+public:
+	/// Serves the requests until an error, returning false, or returns true
+	/// in the processes forked to run a script, setting their arguments
+	static bool serve(Interpreter& interp, const char* path, int* argc, char*** argv);
+private:
+	Zygote() {}
+
+	DISALLOW_COPY_AND_ASSIGN(Zygote);
+};
+
+} // clever
+
+#endif // CLEVER_ZYGOTE_H
@@ -23,6 +23,22 @@ if(PCRECPP_FOUND)
 	add_definitions(-DHAVE_PCRECPP)
 endif()
 
+# systemtap USDT probes
+clever_add_lib(SDT
+	INCS sys/sdt.h)
+
+if(SDT_FOUND)
+	add_definitions(-DHAVE_SYS_SDT_H)
+endif()
+
+# perf_event_open(2), for std.perf
+clever_add_lib(PERF_EVENT
+	INCS linux/perf_event.h)
+
+if(PERF_EVENT_FOUND)
+	add_definitions(-DHAVE_LINUX_PERF_EVENT_H)
+endif()
+
 # libicu
 clever_add_lib(ICU
 	LIBS icuuc
@@ -56,6 +56,12 @@ else()
 		message(STATUS "Use -DENABLE_WPADDED=1 to enable padding messages")
 	endif()
 
+	if(ENABLE_OPCODE_STATS)
+		add_definitions(-DCLEVER_OPCODE_STATS)
+	else()
+		message(STATUS "Use -DENABLE_OPCODE_STATS=1 to build the VM with opcode counters")
+	endif()
+
 	set(CMAKE_CXX_FLAGS_DEBUG   "${CMAKE_CXX_FLAGS_DEBUG} -fno-inline -ggdb -D_DEBUG -DCLEVER_DEBUG")
 	set(CMAKE_CXX_FLAGS_RELEASE "${CMAKE_CXX_FLAGS_RELEASE} -O2 -DNDEBUG")
 	set(CMAKE_CXX_FLAGS_DEVEL   "${CMAKE_CXX_FLAGS_DEBUG} -O0 -Wextra -Wno-unused-parameter -Wno-variadic-macros")
@@ -0,0 +1,142 @@
+/**
+ * Clever programming language
+ * Copyright (c) Clever Team
+ *
+ * This file is distributed under the MIT license. See LICENSE for details.
+ */
+
+// clever-client - runs a script on a script server (clever --server)
+//
+// Usage: CLEVER_SERVER=<socket> clever-client <clever arguments>
+//
+// The arguments are the ones of clever, the script being run with the
+// client's stdin, stdout, stderr, working directory and environment. The
+// signals sent to the client are forwarded to the script and the client
+// exits with its status. Without a server, clever itself is executed.
+
+#include <climits>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include "core/zygote.h"
+
+extern char** environ;
+
+// Process running the script
+static volatile pid_t g_pid = 0;
+
+static void forward_signal(int sig)
+{
+	if (g_pid > 0) {
+		kill(g_pid, sig);
+	}
+}
+
+static int connect_server(const char* path)
+{
+	struct sockaddr_un addr;
+
+	if (strlen(path) >= sizeof(addr.sun_path)) {
+		return -1;
+	}
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	strcpy(addr.sun_path, path);
+
+	int sock = socket(AF_UNIX, SOCK_STREAM, 0);
+
+	if (sock < 0) {
+		return -1;
+	}
+
+	if (connect(sock, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) < 0) {
+		close(sock);
+		return -1;
+	}
+	return sock;
+}
+
+static bool send_request(const clever::ZygoteChannel& conn, int argc, char** argv)
+{
+	static const int fds[clever::ZygoteChannel::NUM_FDS] = { 0, 1, 2 };
+	char cwd[PATH_MAX];
+	std::vector<std::string> args, env;
+
+	if (!getcwd(cwd, sizeof(cwd))) {
+		return false;
+	}
+
+	args.push_back("clever");
+
+	for (int i = 1; i < argc; ++i) {
+		args.push_back(argv[i]);
+	}
+	for (char** var = environ; *var; ++var) {
+		env.push_back(*var);
+	}
+
+	return conn.sendFds(fds) && conn.writeStr(cwd)
+		&& conn.writeList(args) && conn.writeList(env);
+}
+
+int main(int argc, char** argv)
+{
+	if (argc == 1) {
+		std::cout << "Usage: CLEVER_SERVER=<socket> clever-client <clever arguments>\n";
+		return 0;
+	}
+
+	const char* path = getenv("CLEVER_SERVER");
+	int sock = path && *path ? connect_server(path) : -1;
+
+	if (sock < 0) {
+		argv[0] = const_cast<char*>("clever");
+		execvp(argv[0], argv);
+
+		perror("clever");
+		return 127;
+	}
+
+	clever::ZygoteChannel conn(sock);
+	int pid;
+
+	if (!send_request(conn, argc, argv) || !conn.readInt(pid)) {
+		std::cerr << "clever-client: the server rejected the request" << std::endl;
+		return 1;
+	}
+
+	g_pid = pid;
+
+	static const int forwarded[] = { SIGINT, SIGTERM, SIGHUP, SIGQUIT, SIGUSR1, SIGUSR2 };
+	struct sigaction action;
+
+	memset(&action, 0, sizeof(action));
+	action.sa_handler = forward_signal;
+	sigemptyset(&action.sa_mask);
+
+	for (size_t i = 0; i < sizeof(forwarded) / sizeof(forwarded[0]); ++i) {
+		sigaction(forwarded[i], &action, NULL);
+	}
+
+	int status;
+
+	if (!conn.readInt(status)) {
+		std::cerr << "clever-client: lost the connection to the server" << std::endl;
+		return 1;
+	}
+
+	if (WIFSIGNALED(status)) {
+		int sig = WTERMSIG(status);
+
+		// Dies the same way
+		signal(sig, SIG_DFL);
+		raise(sig);
+
+		return 128 + sig;
+	}
+	return WEXITSTATUS(status);
+}
@@ -5,11 +5,32 @@
 # modules.cmake - Module options and other stuff
 #
 
+# Plugins
+# ---------------------------------------------------------------------------
+# The modules depending on 3rd-party libraries can be built as plugins, so
+# the processes only map those libraries when the modules are imported. The
+# other modules are always linked into the runtime.
+option(SHARED_MODULES "build the modules using 3rd-party libraries as plugins" OFF)
+
+set(CLEVER_MODULE_DIR lib/clever)
+
+if(SHARED_MODULES)
+	if(WIN32)
+		message(FATAL_ERROR "SHARED_MODULES is not supported on this platform")
+	endif()
+
+	add_definitions(-DCLEVER_SHARED_MODULES)
+	list(APPEND CLEVER_LIBRARIES dl)
+else()
+	message(STATUS "Use -DSHARED_MODULES=ON to build the modules as plugins")
+endif()
+
 # Modules
 # ---------------------------------------------------------------------------
 # heuripedes: pay attention to the order in which you check the modules.
 #             keep in mind that the check is recursive.
 
+clever_new_module(std.bench      ON DOC "enable the bench module")
 clever_new_module(std.date       ON DOC "enable the date module")
 
 clever_new_module(std.concurrent ON
@@ -22,6 +43,8 @@ clever_new_module(std.file       ON DOC "enable the file module")
 clever_new_module(std.io         ON DOC "enable the io module")
 clever_new_module(std.json       ON DOC "enable the json module")
 clever_new_module(std.math       ON DOC "enable the math module")
+clever_new_module(std.metrics    ON DOC "enable the metrics module")
+clever_new_module(std.perf       ON DOC "enable the perf module")
 clever_new_module(std.reflection ON DOC "enable the reflection module")
 clever_new_module(std.sys        ON DOC "enable the sys module")
 clever_new_module(std.crypto     ON DOC "enable the crypto module")
@@ -30,19 +53,23 @@ clever_new_module(std.getopt     ON DOC "enable the getopt module")
 
 clever_new_module(std.regex ON
 	DOC "enable the regex module"
-	LIBS PCRECPP)
+	LIBS PCRECPP
+	PLUGIN)
 
 clever_new_module(std.ffi ON
 	DOC "enable the ffi module"
-	LIBS FFI)
+	LIBS FFI
+	PLUGIN)
 
 clever_new_module(std.unicode ON
 	DOC	"enable the unicode module"
-	LIBS ICU)
+	LIBS ICU
+	PLUGIN)
 
 clever_new_module(std.fcgi OFF
 	DOC	"enable the fcgi module"
-	LIBS FCGI)
+	LIBS FCGI
+	PLUGIN)
 
 clever_new_module(std.events ON
 	DOC	"enable the event module"
@@ -50,15 +77,18 @@ clever_new_module(std.events ON
 
 clever_new_module(db.mysql ON
 	DOC	"enable the mysql module"
-	LIBS MYSQLC)
+	LIBS MYSQLC
+	PLUGIN)
 
 clever_new_module(db.sqlite3 ON
 	DOC	"enable the sqlite3 module"
-	LIBS SQLITE3)
+	LIBS SQLITE3
+	PLUGIN)
 
 clever_new_module(gui.ncurses ON
 	DOC "enable the ncurses module"
 	LIBS NCURSES
+	PLUGIN
 )
 
 # std.concurrent
@@ -9,15 +9,20 @@
 
 namespace clever { namespace modules {
 
-// Initializes Db package
+// Registers the modules of the Db package, created when imported
+// (the ones built as plugins are loaded then)
 void Db::init()
 {
 #ifdef HAVE_MOD_DB_MYSQL
-	addModule(new db::MysqlModule);
+	addModule("db.mysql",         module_factory<db::MysqlModule>);
+#elif defined(HAVE_PLUGIN_DB_MYSQL)
+	addPlugin("db.mysql");
 #endif
 
 #ifdef HAVE_MOD_DB_SQLITE3
-	addModule(new db::SQLite3Module);
+	addModule("db.sqlite3",       module_factory<db::SQLite3Module>);
+#elif defined(HAVE_PLUGIN_DB_SQLITE3)
+	addPlugin("db.sqlite3");
 #endif
 }
 
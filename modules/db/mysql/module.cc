@@ -10,6 +10,9 @@
 
 namespace clever { namespace modules { namespace db {
 
+// Entry point of the plugin, when built as one
+CLEVER_PLUGIN_MODULE("db.mysql", MysqlModule)
+
 /// Initializes Mysql module
 CLEVER_MODULE_INIT(MysqlModule)
 {
@@ -10,6 +10,9 @@
 
 namespace clever { namespace modules { namespace db {
 
+// Entry point of the plugin, when built as one
+CLEVER_PLUGIN_MODULE("db.sqlite3", SQLite3Module)
+
 CLEVER_MODULE_INIT(SQLite3Module)
 {
 	SQLite3Type* sqlite_type       = new SQLite3Type();
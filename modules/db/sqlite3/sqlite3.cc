@@ -194,9 +194,7 @@ CLEVER_METHOD(SQLite3TypeStmt::bindValue)
 
 	int nparam = sqlite3_bind_parameter_index(stmt->stmt, ss.str().c_str());
 
-	stmt->bound_params.push_back(BoundParamPair(nparam, args[1]));
-
-	clever_addref(args[1]);
+	stmt->bound_params.push_back(BoundParamPair(nparam, args[1]->clone()));
 }
 
 // SQLite3Stmt::execute()
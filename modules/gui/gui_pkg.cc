@@ -6,15 +6,17 @@
  */
 
 #include "modules/gui/gui_pkg.h"
-#include "modules/gui/ncurses/module.h"
 
 namespace clever { namespace modules {
 
-// Initializes Gui package
+// Registers the modules of the Gui package, created when imported
+// (the ones built as plugins are loaded then)
 void Gui::init()
 {
-#if HAVE_MOD_GUI_NCURSES
-	addModule(new gui::NCursesModule);
+#ifdef HAVE_MOD_GUI_NCURSES
+	addModule("gui.ncurses",      module_factory<gui::NCursesModule>);
+#elif defined(HAVE_PLUGIN_GUI_NCURSES)
+	addPlugin("gui.ncurses");
 #endif
 }
 
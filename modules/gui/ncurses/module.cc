@@ -14,6 +14,9 @@ namespace clever { namespace modules { namespace gui {
 
 Type* g_key_type_ref;
 
+// Entry point of the plugin, when built as one
+CLEVER_PLUGIN_MODULE("gui.ncurses", NCursesModule)
+
 CLEVER_MODULE_INIT(NCursesModule)
 {
 	addType(new NCurses);
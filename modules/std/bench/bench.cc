@@ -0,0 +1,563 @@
+/**
+ * Clever programming language
+ * Copyright (c) Clever Team
+ *
+ * This file is distributed under the MIT license. See LICENSE for details.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <ctime>
+#include <iomanip>
+#include <sstream>
+#include "core/value.h"
+#include "core/native_types.h"
+#include "core/cexception.h"
+#include "core/vm.h"
+#include "modules/std/core/array.h"
+#include "modules/std/core/map.h"
+#include "modules/std/core/function.h"
+#include "modules/std/bench/bench.h"
+
+namespace clever { namespace modules { namespace std {
+
+namespace bench {
+
+typedef unsigned long long nsecs_t;
+
+struct Options {
+	Options()
+		: samples(10), warmup(100000000ULL), sample_time(50000000ULL), iterations(0) {}
+
+	size_t samples;
+	nsecs_t warmup;
+	nsecs_t sample_time;
+	// Iterations per sample, calibrated during the warmup when zero
+	size_t iterations;
+	::std::string name;
+};
+
+struct Result {
+	Result()
+		: iterations(0), mean(0), median(0), stddev(0), min(0), max(0),
+			p75(0), p90(0), p99(0), rme(0) {}
+
+	::std::string name;
+	size_t iterations;
+	// Time per iteration of each sample, in nanoseconds
+	::std::vector<double> times;
+	double mean, median, stddev, min, max, p75, p90, p99;
+	// Relative margin of error of the mean, 95% confidence, in percent
+	double rme;
+};
+
+static nsecs_t now()
+{
+#ifndef CLEVER_WIN32
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return nsecs_t(ts.tv_sec) * 1000000000ULL + ts.tv_nsec;
+#else
+	LARGE_INTEGER freq, count;
+
+	QueryPerformanceFrequency(&freq);
+	QueryPerformanceCounter(&count);
+
+	return nsecs_t(count.QuadPart) * 1000000000ULL / freq.QuadPart;
+#endif
+}
+
+// Two-tailed 95% critical values of the Student's t distribution
+static double t_critical(double df)
+{
+	static const double table[] = {
+		12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+		2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+		2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042
+	};
+	size_t n = sizeof(table) / sizeof(table[0]);
+
+	if (df < 1) {
+		return table[0];
+	}
+	return df <= n ? table[size_t(df) - 1] : 1.96;
+}
+
+// Linear interpolation between the closest ranks
+static double percentile(const ::std::vector<double>& sorted, double p)
+{
+	double pos = p * (sorted.size() - 1);
+	size_t lower = size_t(pos);
+
+	if (lower + 1 >= sorted.size()) {
+		return sorted.back();
+	}
+	return sorted[lower] + (sorted[lower + 1] - sorted[lower]) * (pos - lower);
+}
+
+static double variance(const Result& result)
+{
+	return result.stddev * result.stddev;
+}
+
+static void summarize(Result& result)
+{
+	::std::vector<double> sorted(result.times);
+	size_t n = sorted.size();
+	double sum = 0, squares = 0;
+
+	::std::sort(sorted.begin(), sorted.end());
+
+	for (size_t i = 0; i < n; ++i) {
+		sum += sorted[i];
+	}
+	result.mean = sum / n;
+
+	for (size_t i = 0; i < n; ++i) {
+		squares += (sorted[i] - result.mean) * (sorted[i] - result.mean);
+	}
+	result.stddev = n > 1 ? ::std::sqrt(squares / (n - 1)) : 0;
+
+	result.min    = sorted.front();
+	result.max    = sorted.back();
+	result.median = percentile(sorted, .5);
+	result.p75    = percentile(sorted, .75);
+	result.p90    = percentile(sorted, .9);
+	result.p99    = percentile(sorted, .99);
+
+	result.rme = result.mean > 0
+		? t_critical(n - 1) * result.stddev / ::std::sqrt(double(n)) / result.mean * 100 : 0;
+}
+
+static bool call(Function* func, Clever* clever)
+{
+	ValueVector args;
+
+	const_cast<VM*>(clever->vm)->runFunction(func, args)->delRef();
+
+	return !clever->exception->hasException();
+}
+
+// Warms up, calibrates the iterations so that a sample takes about
+// sample_time and then takes the samples
+static bool measure(Function* func, const Options& opts, Result& result, Clever* clever)
+{
+	nsecs_t start = now(), elapsed;
+	size_t calls = 0;
+
+	do {
+		if (!call(func, clever)) {
+			return false;
+		}
+		++calls;
+		elapsed = now() - start;
+	} while (elapsed < opts.warmup);
+
+	result.iterations = opts.iterations;
+
+	if (!result.iterations) {
+		result.iterations = ::std::max(size_t(1),
+			size_t(double(opts.sample_time) * calls / ::std::max(elapsed, nsecs_t(1))));
+	}
+
+	for (size_t i = 0; i < opts.samples; ++i) {
+		start = now();
+
+		for (size_t j = 0; j < result.iterations; ++j) {
+			if (!call(func, clever)) {
+				return false;
+			}
+		}
+
+		result.times.push_back(double(now() - start) / result.iterations);
+	}
+
+	result.name = opts.name.empty() ? func->getName() : opts.name;
+
+	summarize(result);
+
+	return true;
+}
+
+static double get_number(const Value* value)
+{
+	return value->isInt() ? double(value->getInt()) : value->getDouble();
+}
+
+static bool parse_options(const Value* value, Options& opts, Clever* clever)
+{
+	const MapObject* map = static_cast<const MapObject*>(value->getObj());
+	const ::std::map< ::std::string, Value*>& data = map->getData();
+	::std::map< ::std::string, Value*>::const_iterator it(data.begin()), end(data.end());
+
+	for (; it != end; ++it) {
+		const Value* option = it->second;
+
+		if (it->first == "name" && option->isStr()) {
+			opts.name = *option->getStr();
+			continue;
+		}
+
+		if (it->first == "name" || (!option->isInt() && !option->isDouble())
+			|| get_number(option) < 0) {
+			clever_throw("Invalid value for the option `%s'", it->first.c_str());
+			return false;
+		}
+
+		double number = get_number(option);
+
+		if (it->first == "samples" && number >= 1) {
+			opts.samples = size_t(number);
+		} else if (it->first == "warmup") {
+			opts.warmup = nsecs_t(number * 1e6);
+		} else if (it->first == "time" && number > 0) {
+			opts.sample_time = nsecs_t(number * 1e6);
+		} else if (it->first == "iterations") {
+			opts.iterations = size_t(number);
+		} else {
+			clever_throw("Invalid option `%s'", it->first.c_str());
+			return false;
+		}
+	}
+	return true;
+}
+
+static Value* new_map(MapObject* map)
+{
+	Value* value = new Value();
+
+	value->setObj(CLEVER_MAP_TYPE, map);
+
+	return value;
+}
+
+static Value* new_str(const ::std::string& str)
+{
+	Value* value = new Value();
+
+	value->setStr(new StrObject(str));
+
+	return value;
+}
+
+static MapObject* result_map(const Result& result)
+{
+	MapObject* map = new MapObject;
+	::std::vector<Value*> times;
+
+	for (size_t i = 0, j = result.times.size(); i < j; ++i) {
+		times.push_back(new Value(result.times[i]));
+	}
+
+	Value* times_val = new Value();
+
+	times_val->setObj(CLEVER_ARRAY_TYPE, new ArrayObject(times));
+	::std::for_each(times.begin(), times.end(), clever_delref);
+
+	map->insertValue("name",        new_str(result.name));
+	map->insertValue("samples",     new Value(long(result.times.size())));
+	map->insertValue("iterations",  new Value(long(result.iterations)));
+	map->insertValue("times",       times_val);
+	map->insertValue("mean",        new Value(result.mean));
+	map->insertValue("median",      new Value(result.median));
+	map->insertValue("stddev",      new Value(result.stddev));
+	map->insertValue("min",         new Value(result.min));
+	map->insertValue("max",         new Value(result.max));
+	map->insertValue("p75",         new Value(result.p75));
+	map->insertValue("p90",         new Value(result.p90));
+	map->insertValue("p99",         new Value(result.p99));
+	map->insertValue("rme",         new Value(result.rme));
+	map->insertValue("ops_per_sec", new Value(result.mean > 0 ? 1e9 / result.mean : 0.0));
+
+	return map;
+}
+
+// Fetches a member of a map returned by run() or compare()
+static const Value* get_member(const Value* value, const char* key)
+{
+	if (!value->isMap()) {
+		return NULL;
+	}
+
+	const MapObject* map = static_cast<const MapObject*>(value->getObj());
+	::std::map< ::std::string, Value*>::const_iterator it = map->getData().find(key);
+
+	return it != map->getData().end() ? it->second : NULL;
+}
+
+static bool get_double(const Value* value, const char* key, double& out)
+{
+	const Value* member = get_member(value, key);
+
+	if (!member || (!member->isInt() && !member->isDouble())) {
+		return false;
+	}
+	out = get_number(member);
+
+	return true;
+}
+
+static ::std::string format_time(double nsecs)
+{
+	static const char* units[] = { "ns", "us", "ms", "s" };
+	::std::ostringstream out;
+	size_t unit = 0;
+
+	while (unit < 3 && nsecs >= 1000) {
+		nsecs /= 1000;
+		++unit;
+	}
+
+	out << ::std::fixed << ::std::setprecision(3) << nsecs << " " << units[unit];
+
+	return out.str();
+}
+
+// Formats a run() result as a single line
+static bool format_result(const Value* value, ::std::ostream& out)
+{
+	const Value* name = get_member(value, "name");
+	double samples, iterations, mean, median, p99, rme, ops;
+
+	if (!name || !name->isStr()
+		|| !get_double(value, "samples", samples)
+		|| !get_double(value, "iterations", iterations)
+		|| !get_double(value, "mean", mean)
+		|| !get_double(value, "median", median)
+		|| !get_double(value, "p99", p99)
+		|| !get_double(value, "rme", rme)
+		|| !get_double(value, "ops_per_sec", ops)) {
+		return false;
+	}
+
+	out << *name->getStr() << ": " << format_time(mean) << "/op"
+		<< ::std::fixed << ::std::setprecision(2) << " +/-" << rme << "%"
+		<< " (median " << format_time(median) << ", p99 " << format_time(p99) << "), "
+		<< ::std::setprecision(0) << ops << " ops/sec, "
+		<< samples << " samples of " << iterations << " iterations";
+
+	return true;
+}
+
+static void write_json_string(const ::std::string& str, ::std::ostream& out)
+{
+	out << "\"";
+	for (size_t i = 0, j = str.size(); i < j; ++i) {
+		unsigned char c = str[i];
+
+		if (c == '"' || c == '\\') {
+			out << '\\' << c;
+		} else if (c == '\n') {
+			out << "\\n";
+		} else if (c < 0x20) {
+			out << "\\u00" << "0123456789abcdef"[c >> 4] << "0123456789abcdef"[c & 0xf];
+		} else {
+			out << c;
+		}
+	}
+	out << "\"";
+}
+
+static void write_json(const Value* value, ::std::ostream& out)
+{
+	if (!value) {
+		out << "null";
+	} else if (value->isMap()) {
+		const MapObject* map = static_cast<const MapObject*>(value->getObj());
+		::std::map< ::std::string, Value*>::const_iterator it(map->getData().begin()),
+			end(map->getData().end());
+
+		out << "{";
+		for (bool first = true; it != end; ++it, first = false) {
+			out << (first ? "" : ", ");
+			write_json_string(it->first, out);
+			out << ": ";
+			write_json(it->second, out);
+		}
+		out << "}";
+	} else if (value->isArray()) {
+		const ::std::vector<Value*>& data =
+			static_cast<const ArrayObject*>(value->getObj())->getData();
+
+		out << "[";
+		for (size_t i = 0, j = data.size(); i < j; ++i) {
+			out << (i ? ", " : "");
+			write_json(data[i], out);
+		}
+		out << "]";
+	} else if (value->isStr()) {
+		write_json_string(*value->getStr(), out);
+	} else if (value->isBool()) {
+		out << (value->getBool() ? "true" : "false");
+	} else if (value->isInt()) {
+		out << value->getInt();
+	} else if (value->isDouble() && value->getDouble() == value->getDouble()
+		&& ::std::fabs(value->getDouble()) != HUGE_VAL) {
+		out << ::std::setprecision(15) << value->getDouble();
+	} else {
+		out << "null";
+	}
+}
+
+// now()
+// Returns the monotonic clock in nanoseconds, for timing code by hand
+static CLEVER_FUNCTION(now)
+{
+	if (!clever_static_check_no_args()) {
+		return;
+	}
+
+	result->setInt(long(now()));
+}
+
+// run(function fn [, map options])
+// Benchmarks fn: calls it for `warmup' ms (100), calibrates the iterations so
+// that each sample lasts `time' ms (50), unless `iterations' is given, and
+// takes `samples' samples (10). Returns a map with the time per iteration of
+// each sample (`times') and their mean, median, stddev, min, max, p75, p90,
+// p99, 95% relative margin of error (`rme', in percent) and `ops_per_sec';
+// times are in nanoseconds
+static CLEVER_FUNCTION(run)
+{
+	if (!clever_static_check_args("f|m")) {
+		return;
+	}
+
+	Options opts;
+	Result res;
+
+	if (args.size() > 1 && !parse_options(args[1], opts, clever)) {
+		return;
+	}
+
+	if (measure(static_cast<Function*>(args[0]->getObj()), opts, res, clever)) {
+		result->setObj(CLEVER_MAP_TYPE, result_map(res));
+	}
+}
+
+// compare(function a, function b [, map options])
+// Benchmarks a and b with the same options, returning a map with both results
+// (`a' and `b'), the `ratio' of the mean of b to the mean of a, which one is
+// `faster' ("a" or "b") and whether the difference is `significant' according
+// to Welch's t-test at 95% confidence
+static CLEVER_FUNCTION(compare)
+{
+	if (!clever_static_check_args("ff|m")) {
+		return;
+	}
+
+	Options opts;
+	Result res_a, res_b;
+
+	if (args.size() > 2 && !parse_options(args[2], opts, clever)) {
+		return;
+	}
+
+	if (!measure(static_cast<Function*>(args[0]->getObj()), opts, res_a, clever)
+		|| !measure(static_cast<Function*>(args[1]->getObj()), opts, res_b, clever)) {
+		return;
+	}
+
+	if (opts.name.empty() && res_a.name == res_b.name) {
+		res_a.name = "a";
+		res_b.name = "b";
+	}
+
+	double na = res_a.times.size(), nb = res_b.times.size();
+	double va = variance(res_a) / na, vb = variance(res_b) / nb;
+	double se = ::std::sqrt(va + vb);
+	bool significant;
+
+	if (se > 0) {
+		double t = ::std::fabs(res_a.mean - res_b.mean) / se;
+		double df = (va + vb) * (va + vb)
+			/ ((na > 1 ? va * va / (na - 1) : 0) + (nb > 1 ? vb * vb / (nb - 1) : 0));
+
+		significant = t > t_critical(df);
+	} else {
+		significant = res_a.mean != res_b.mean;
+	}
+
+	MapObject* map = new MapObject;
+
+	map->insertValue("a",           new_map(result_map(res_a)));
+	map->insertValue("b",           new_map(result_map(res_b)));
+	map->insertValue("ratio",       new Value(res_a.mean > 0 ? res_b.mean / res_a.mean : 0.0));
+	map->insertValue("faster",      new_str(res_a.mean <= res_b.mean ? "a" : "b"));
+	map->insertValue("significant", new Value(significant));
+
+	result->setObj(CLEVER_MAP_TYPE, map);
+}
+
+// format(map result)
+// Returns a human-readable report of a run() or compare() result
+static CLEVER_FUNCTION(format)
+{
+	if (!clever_static_check_args("m")) {
+		return;
+	}
+
+	::std::ostringstream out;
+	const Value* a = get_member(args[0], "a");
+	const Value* b = get_member(args[0], "b");
+
+	if (a && b) {
+		const Value* faster = get_member(args[0], "faster");
+		const Value* significant = get_member(args[0], "significant");
+		double ratio;
+
+		bool valid = format_result(a, out);
+
+		out << "\n";
+
+		if (!valid || !format_result(b, out) || !faster || !faster->isStr() || !significant || !significant->isBool()
+			|| !get_double(args[0], "ratio", ratio)) {
+			clever_throw("Expected the result of bench:compare()");
+			return;
+		}
+
+		bool a_faster = *faster->getStr() == "a";
+
+		out << "\n" << *get_member(a_faster ? a : b, "name")->getStr() << " is "
+			<< ::std::fixed << ::std::setprecision(2) << (a_faster ? ratio : 1 / ratio)
+			<< "x faster than " << *get_member(a_faster ? b : a, "name")->getStr()
+			<< (significant->getBool() ? "" : " (not significant)");
+	} else if (!format_result(args[0], out)) {
+		clever_throw("Expected the result of bench:run() or bench:compare()");
+		return;
+	}
+
+	result->setStr(new StrObject(out.str()));
+}
+
+// json(map result)
+// Returns a run() or compare() result, or any map of numbers, strings and
+// arrays, as JSON
+static CLEVER_FUNCTION(json)
+{
+	if (!clever_static_check_args("m")) {
+		return;
+	}
+
+	::std::ostringstream out;
+
+	write_json(args[0], out);
+
+	result->setStr(new StrObject(out.str()));
+}
+
+} // clever::modules::std::bench
+
+// Load module data
+CLEVER_MODULE_INIT(BenchModule)
+{
+	addFunction(new Function("now",     &CLEVER_NS_FNAME(bench, now)));
+	addFunction(new Function("run",     &CLEVER_NS_FNAME(bench, run)));
+	addFunction(new Function("compare", &CLEVER_NS_FNAME(bench, compare)));
+	addFunction(new Function("format",  &CLEVER_NS_FNAME(bench, format)));
+	addFunction(new Function("json",    &CLEVER_NS_FNAME(bench, json)));
+}
+
+}}} // clever::modules::std
@@ -0,0 +1,30 @@
+/**
+ * Clever programming language
+ * Copyright (c) Clever Team
+ *
+ * This file is distributed under the MIT license. See LICENSE for details.
+ */
+
+#ifndef CLEVER_STD_BENCH_H
+#define CLEVER_STD_BENCH_H
+
+#include "core/module.h"
+
+namespace clever { namespace modules { namespace std {
+
+/// Standard Bench module (benchmark harness)
+class BenchModule : public Module {
+public:
+	BenchModule()
+		: Module("std.bench") {}
+
+	~BenchModule() {}
+
+	CLEVER_MODULE_VIRTUAL_METHODS_DECLARATION;
+private:
+	DISALLOW_COPY_AND_ASSIGN(BenchModule);
+};
+
+}}} // clever::modules::std
+
+#endif // CLEVER_STD_BENCH_H
@@ -54,7 +54,11 @@ CLEVER_METHOD(Mutex::unlock)
 
 CLEVER_METHOD(Mutex::ctor)
 {
-	result->setObj(this, new MutexObject);
+	MutexObject* mobj = new MutexObject;
+
+	mobj->mutex.setName(LockStats::nameHere("Mutex"));
+
+	result->setObj(this, mobj);
 }
 
 CLEVER_TYPE_INIT(Mutex::init)
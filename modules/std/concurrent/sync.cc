@@ -82,7 +82,11 @@ CLEVER_METHOD(Sync::ctor)
 	if (!clever_check_args("i")) {
 		return;
 	}
-	result->setObj(this, new SyncObject(args[0]->getInt()));
+	SyncObject* sobj = new SyncObject(args[0]->getInt());
+
+	sobj->mutex.setName(LockStats::nameHere("Sync"));
+
+	result->setObj(this, sobj);
 }
 
 CLEVER_TYPE_INIT(Sync::init)
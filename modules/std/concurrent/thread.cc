@@ -8,6 +8,8 @@
 #include "core/clever.h"
 #include "core/value.h"
 #include "core/type.h"
+#include "core/probes.h"
+#include "core/metrics.h"
 #include "modules/std/concurrent/module.h"
 #include "modules/std/concurrent/thread.h"
 #include "modules/std/core/function.h"
@@ -23,11 +25,25 @@ static inline void* ThreadHandler(void* ThreadArgument)
 {
 	ThreadData* intern = static_cast<ThreadData*>(ThreadArgument);
 
+	CLEVER_PROBE2(thread__start, intern->entry->getName().c_str(), intern);
+
+	// The thread runs in the isolate of the one which started it
+	Isolate::setCurrent(intern->isolate);
+
+	Metrics::threadStarted();
+
 	if (intern->vm) {
-		intern->result = intern->vm->runFunction(intern->entry, intern->args);
+		if (setjmp(fatal_error) == 0) {
+			intern->result = intern->vm->runFunction(intern->entry, intern->args);
+		} else {
+			// A fatal error only ends the thread
+			VM::setCurrent(NULL);
+		}
 		delete intern->vm;
 	}
 
+	Metrics::threadFinished();
+
 #ifndef CLEVER_WIN32
 	pthread_exit(NULL);
 #endif
@@ -45,6 +61,8 @@ ThreadData::~ThreadData()
 	if (!joined) {
 		//clever_debug("Thread.dtor calling pthread_join for %@", thread);
 		thread.wait();
+
+		CLEVER_PROBE2(thread__join, entry ? entry->getName().c_str() : "", this);
 		//if (pthread_join(thread, NULL) != 0) {
 			//clever_debug("Thread.dtor failed to join with %@", thread);
 		//} else {
@@ -88,6 +106,7 @@ CLEVER_METHOD(Thread::start)
 		//clever_debug("Thread.start set vm for thread to %@", vm);
 
 		intern->vm = new VM(*clever->vm);
+		intern->isolate = Isolate::getCurrent();
 		intern->thread.create(ThreadHandler, intern);
 
 		//clever_debug("Thread.start created thread at %@", intern->thread);
@@ -113,6 +132,8 @@ CLEVER_METHOD(Thread::wait)
 	if (!intern->joined) {
 		intern->thread.wait();
 		intern->joined = true;
+
+		CLEVER_PROBE2(thread__join, intern->entry->getName().c_str(), intern);
 	}
 	intern->lock.unlock();
 }
@@ -18,7 +18,7 @@ namespace clever { namespace modules { namespace std {
 
 struct ThreadData : public TypeObject {
 	ThreadData()
-		: entry(NULL), result(NULL), vm(NULL) {}
+		: entry(NULL), result(NULL), vm(NULL), isolate(NULL) {}
 
 	~ThreadData();
 
@@ -27,6 +27,7 @@ struct ThreadData : public TypeObject {
 	const Function* entry;
 	Value* result;
 	VM* vm;
+	Isolate* isolate;
 	::std::vector<Value*> args;
 	bool joined;
 };
@@ -12,10 +12,44 @@
 
 namespace clever {
 
+ArrayStorage* ArrayStorage::clone() const
+{
+	ArrayStorage* storage = new ArrayStorage;
+
+	storage->data.reserve(data.size());
+
+	for (size_t i = 0, n = data.size(); i < n; ++i) {
+		storage->data.push_back(data[i] ? data[i]->clone() : NULL);
+	}
+
+	return storage;
+}
+
+// Gives this array its own copy of a shared element buffer
+void ArrayObject::detach()
+{
+	ArrayStorage* storage = m_storage->clone();
+
+	m_storage->delRef();
+	m_storage = storage;
+}
+
+void ArrayObject::append(const ArrayObject* other)
+{
+	ArrayStorage* source = other->m_storage;
+
+	// Holding the source buffer makes `arr += arr` detach before pushing
+	source->addRef();
+
+	append(source->data);
+
+	source->delRef();
+}
+
 ::std::string ArrayType::toString(TypeObject* value) const
 {
-	ArrayObject* arr = static_cast<ArrayObject*>(value);
-	ValueVector& vec = arr->getData();
+	const ArrayObject* arr = static_cast<ArrayObject*>(value);
+	const ValueVector& vec = arr->getData();
 	::std::ostringstream out;
 
 	out << "[";
@@ -41,8 +75,8 @@ namespace clever {
 // Subscript operator
 CLEVER_TYPE_AT_OPERATOR(ArrayType::at_op)
 {
-	ValueVector& arr = clever_get_this(ArrayObject*)->getData();
-	long size = arr.size();
+	ArrayObject* arrobj = clever_get_this(ArrayObject*);
+	long size = static_cast<const ArrayObject*>(arrobj)->getData().size();
 
 	if (!index->isInt()) {
 		clever_throw("Invalid array index type");
@@ -54,14 +88,19 @@ CLEVER_TYPE_AT_OPERATOR(ArrayType::at_op)
 		return NULL;
 	}
 
+	Value* result;
+
 	if (is_write) {
+		ValueVector& arr = arrobj->getData();
+
 		if (!arr[index->getInt()]) {
 			arr[index->getInt()] = new Value;
 		}
+		result = arr[index->getInt()];
+	} else {
+		result = static_cast<const ArrayObject*>(arrobj)->getData()[index->getInt()];
 	}
 
-	Value* result = arr.at(index->getInt());
-
 	clever_addref(result);
 
 	return result;
@@ -75,11 +114,11 @@ CLEVER_TYPE_OPERATOR(ArrayType::add)
 		ArrayObject* arr2 = clever_get_object(ArrayObject*, rhs);
 
 		if (result == lhs) {
-			static_cast<ArrayObject*>(result->getObj())->append(arr2->getData());
+			arr->append(arr2);
 		} else {
-			ArrayObject* new_obj = new ArrayObject(arr->getData());
+			ArrayObject* new_obj = new ArrayObject(arr);
 
-			new_obj->append(arr2->getData());
+			new_obj->append(arr2);
 
 			result->setObj(this, new_obj);
 		}
@@ -116,7 +155,7 @@ CLEVER_METHOD(ArrayType::size)
 		return;
 	}
 
-	result->setInt(clever_get_this(ArrayObject*)->getData().size());
+	result->setInt(clever_get_this(const ArrayObject*)->getData().size());
 }
 
 // mixed Array::at(int position)
@@ -126,7 +165,7 @@ CLEVER_METHOD(ArrayType::at)
 		return;
 	}
 
-	ValueVector& arr = clever_get_this(ArrayObject*)->getData();
+	const ValueVector& arr = clever_get_this(const ArrayObject*)->getData();
 
 	long num = args[0]->getInt();
 
@@ -183,8 +222,8 @@ CLEVER_METHOD(ArrayType::reverse)
 		return;
 	}
 
-	ValueVector& vec = clever_get_this(ArrayObject*)->getData();
-	ValueVector::reverse_iterator it(vec.rbegin()), end(vec.rend());
+	const ValueVector& vec = clever_get_this(const ArrayObject*)->getData();
+	ValueVector::const_reverse_iterator it(vec.rbegin()), end(vec.rend());
 	ValueVector rev;
 
 	while (it != end){
@@ -245,7 +284,7 @@ CLEVER_METHOD(ArrayType::range)
 		return;
 	}
 
-	ValueVector& vec = clever_get_this(ArrayObject*)->getData();
+	const ValueVector& vec = clever_get_this(const ArrayObject*)->getData();
 
 	if (vec.empty()){
 		result->setNull();
@@ -285,7 +324,7 @@ CLEVER_METHOD(ArrayType::each)
 	}
 
 	Function* func = static_cast<Function*>(args[0]->getObj());
-	ValueVector& vec = clever_get_this(ArrayObject*)->getData();
+	const ValueVector& vec = clever_get_this(const ArrayObject*)->getData();
 	ValueVector results;
 
 	for (size_t i = 0, j = vec.size(); i < j; ++i) {
@@ -346,7 +385,8 @@ CLEVER_METHOD(ArrayType::end)
 	ArrayObject* arr = clever_get_this(ArrayObject*);
 
 	result->setObj(CLEVER_ARRAYITER_TYPE,
-		new ArrayIteratorObject(arr, arr->getData().end()));
+		new ArrayIteratorObject(arr, arr->getStorage(),
+			arr->getStorage()->data.end()));
 }
 
 // Type initialization
@@ -411,7 +451,8 @@ CLEVER_METHOD(ArrayIterator::next)
 	ArrayIteratorObject* iter_obj = clever_get_this(ArrayIteratorObject*);
 	ArrayIteratorObject::InternalIteratorType it = iter_obj->getNext();
 
-	result->setObj(this, new ArrayIteratorObject(iter_obj->getArray(), it));
+	result->setObj(this, new ArrayIteratorObject(iter_obj->getArray(),
+		iter_obj->getStorage(), it));
 }
 
 // Operators
@@ -16,36 +16,86 @@
 
 namespace clever {
 
+/**
+ * @brief Element buffer shared between ArrayObject instances
+ *
+ * The buffer is only copied when one of the sharing arrays needs to change
+ * it (copy-on-write), making read-only sharing O(1).
+ */
+class ArrayStorage : public RefCounted {
+public:
+	ArrayStorage() {}
+
+	~ArrayStorage() {
+		std::for_each(data.begin(), data.end(), clever_delref);
+	}
+
+	/// Creates an unshared copy of the buffer
+	ArrayStorage* clone() const;
+
+	std::vector<Value*> data;
+private:
+	DISALLOW_COPY_AND_ASSIGN(ArrayStorage);
+};
+
 class ArrayObject : public TypeObject {
 public:
-	ArrayObject() {}
+	ArrayObject()
+		: m_storage(new ArrayStorage) {}
 
-	explicit ArrayObject(const std::vector<Value*>& args) {
+	explicit ArrayObject(const std::vector<Value*>& args)
+		: m_storage(new ArrayStorage) {
 		append(args);
 	}
 
+	/// Creates an array sharing the elements of `other` until one changes
+	explicit ArrayObject(const ArrayObject* other)
+		: m_storage(other->m_storage) {
+		m_storage->addRef();
+	}
+
 	~ArrayObject() {
-		std::for_each(m_data.begin(), m_data.end(), clever_delref);
+		m_storage->delRef();
 	}
 
 	void append(const std::vector<Value*>& args) {
+		std::vector<Value*>& data = getData();
+
+		data.reserve(data.size() + args.size());
+
 		for (size_t i = 0, n = args.size(); i < n; ++i) {
 			pushValue(args[i]);
 		}
 	}
 
+	void append(const ArrayObject*);
+
 	void pushValue(Value* value) {
 		if (value) {
-			m_data.push_back(value->clone());
-			m_data.back()->setConst(false);
+			getData().push_back(value->clone());
+			m_storage->data.back()->setConst(false);
 		} else {
-			m_data.push_back(NULL);
+			getData().push_back(NULL);
+		}
+	}
+
+	/// Returns the elements for writing, detaching from a shared buffer
+	std::vector<Value*>& getData() {
+		if (UNEXPECTED(isShared())) {
+			detach();
 		}
+		return m_storage->data;
 	}
 
-	std::vector<Value*>& getData() { return m_data; }
+	const std::vector<Value*>& getData() const { return m_storage->data; }
+
+	ArrayStorage* getStorage() const { return m_storage; }
+
+	bool isShared() const { return m_storage->refCount() > 1; }
 private:
-	std::vector<Value*> m_data;
+	void detach();
+
+	ArrayStorage* m_storage;
 
 	DISALLOW_COPY_AND_ASSIGN(ArrayObject);
 };
@@ -55,14 +105,20 @@ public:
 
 	typedef std::vector<Value*>::iterator InternalIteratorType;
 
+	// The iterator holds the element buffer it points into, so that a
+	// copy-on-write detach of the array cannot invalidate it.
 	ArrayIteratorObject(ArrayObject* array)
-		: m_array(array), m_iterator(array->getData().begin()) {
+		: m_array(array), m_storage(array->getStorage()),
+			m_iterator(m_storage->data.begin()) {
 		clever_addref(m_array);
+		clever_addref(m_storage);
 	}
 
-	ArrayIteratorObject(ArrayObject* array, const InternalIteratorType& iter)
-		: m_array(array), m_iterator(iter) {
+	ArrayIteratorObject(ArrayObject* array, ArrayStorage* storage,
+		const InternalIteratorType& iter)
+		: m_array(array), m_storage(storage), m_iterator(iter) {
 		clever_addref(m_array);
+		clever_addref(m_storage);
 	}
 
 	InternalIteratorType& getIterator() {
@@ -75,18 +131,24 @@ public:
 	}
 
 	bool isValid() const {
-		return m_iterator != m_array->getData().end();
+		return m_iterator != m_storage->data.end();
 	}
 
 	ArrayObject* getArray() const {
 		return m_array;
 	}
 
+	ArrayStorage* getStorage() const {
+		return m_storage;
+	}
+
 	~ArrayIteratorObject() {
+		clever_delref(m_storage);
 		clever_delref(m_array);
 	}
 private:
 	ArrayObject* m_array;
+	ArrayStorage* m_storage;
 	InternalIteratorType m_iterator;
 	DISALLOW_COPY_AND_ASSIGN(ArrayIteratorObject);
 };
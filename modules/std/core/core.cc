@@ -11,22 +11,6 @@
 #include "core/native_types.h"
 #include "core/type.h"
 
-namespace clever {
-
-// Native types
-Type* g_clever_int_type;
-Type* g_clever_double_type;
-Type* g_clever_str_type;
-Type* g_clever_func_type;
-Type* g_clever_bool_type;
-Type* g_clever_array_type;
-Type* g_clever_map_type;
-
-// Iterators
-Type* g_clever_arrayiterator_type;
-
-} // clever
-
 namespace clever { namespace modules { namespace std {
 
 CLEVER_MODULE_INIT(CoreModule)
@@ -13,10 +13,32 @@
 
 namespace clever {
 
+MapStorage* MapStorage::clone() const
+{
+	MapStorage* storage = new MapStorage;
+	ValueMap::const_iterator it(data.begin()), end(data.end());
+
+	for (; it != end; ++it) {
+		storage->data.insert(storage->data.end(),
+			ValuePair(it->first, it->second->clone()));
+	}
+
+	return storage;
+}
+
+// Gives this map its own copy of a shared entry storage
+void MapObject::detach()
+{
+	MapStorage* storage = m_storage->clone();
+
+	m_storage->delRef();
+	m_storage = storage;
+}
+
 std::string MapType::toString(TypeObject* value) const
 {
-	MapObject* arr = static_cast<MapObject*>(value);
-	ValueMap& map = arr->getData();
+	const MapObject* arr = static_cast<MapObject*>(value);
+	const ValueMap& map = arr->getData();
 	ValueMap::const_iterator it(map.begin()), end(map.end());
 	std::ostringstream out;
 
@@ -49,19 +71,20 @@ CLEVER_METHOD(MapType::ctor)
 CLEVER_TYPE_AT_OPERATOR(MapType::at_op)
 {
 	MapObject* mobj = clever_get_this(MapObject*);
-	std::map<std::string, Value*>& data = mobj->getData();
 
 	if (!index->isStr()) {
 		clever_throw("Invalid map index type");
 		return NULL;
 	}
 
+	const std::map<std::string, Value*>& data = is_write
+		? mobj->getData() : static_cast<const MapObject*>(mobj)->getData();
 	std::map<std::string, Value*>::const_iterator it = data.find(*index->getStr());
 	Value* item = NULL;
 
 	if (is_write) {
 		if (it == data.end()) {
-			item = data[*index->getStr()] = new Value;
+			item = mobj->getData()[*index->getStr()] = new Value;
 		} else {
 			item = it->second;
 		}
@@ -99,7 +122,7 @@ CLEVER_METHOD(MapType::exists)
 		return;
 	}
 
-	ValueMap& mapped = clever_get_this(MapObject*)->getData();
+	const ValueMap& mapped = clever_get_this(const MapObject*)->getData();
 	result->setBool(mapped.find(*args[0]->getStr()) != mapped.end());
 }
 
@@ -113,7 +136,7 @@ CLEVER_METHOD(MapType::each)
 	}
 
 	Function* func = static_cast<Function*>(args[0]->getObj());
-	ValueMap& map = clever_get_this(MapObject*)->getData();
+	const ValueMap& map = clever_get_this(const MapObject*)->getData();
 	ValueMap::const_iterator it(map.begin()), end(map.end());
 	ValueVector results;
 
@@ -148,7 +171,7 @@ CLEVER_METHOD(MapType::size)
 		return;
 	}
 
-	result->setInt(clever_get_this(MapObject*)->getData().size());
+	result->setInt(clever_get_this(const MapObject*)->getData().size());
 }
 
 CLEVER_TYPE_INIT(MapType::init)
@@ -18,11 +18,38 @@ namespace clever {
 
 typedef std::pair<std::string, Value*> MapObjectPair;
 
+/**
+ * @brief Entry storage shared between MapObject instances
+ *
+ * Like ArrayStorage, it is only copied when a sharing map needs to change it.
+ */
+class MapStorage : public RefCounted {
+public:
+	MapStorage() {}
+
+	~MapStorage() {
+		ValueMap::const_iterator it(data.begin()), end(data.end());
+
+		for (; it != end; ++it) {
+			clever_delref(it->second);
+		}
+	}
+
+	/// Creates an unshared copy of the entries
+	MapStorage* clone() const;
+
+	std::map<std::string, Value*> data;
+private:
+	DISALLOW_COPY_AND_ASSIGN(MapStorage);
+};
+
 class MapObject : public TypeObject{
 public:
-	MapObject() {}
+	MapObject()
+		: m_storage(new MapStorage) {}
 
-	MapObject(const ::std::vector<Value*>& args) {
+	MapObject(const ::std::vector<Value*>& args)
+		: m_storage(new MapStorage) {
 		for (size_t i = 0, j = args.size(); i < j; i += 2) {
 			Value* val = new Value();
 
@@ -32,21 +59,35 @@ public:
 		}
 	}
 
-	~MapObject() {
-		ValueMap::const_iterator it(m_data.begin()), end(m_data.end());
+	/// Creates a map sharing the entries of `other` until one changes
+	explicit MapObject(const MapObject* other)
+		: m_storage(other->m_storage) {
+		m_storage->addRef();
+	}
 
-		for (; it != end; ++it) {
-			clever_delref(it->second);
-		}
+	~MapObject() {
+		m_storage->delRef();
 	}
 
 	void insertValue(const ::std::string& str, Value* val) {
-		m_data.insert(ValuePair(str, val));
+		getData().insert(ValuePair(str, val));
+	}
+
+	/// Returns the entries for writing, detaching from a shared storage
+	std::map<std::string, Value*>& getData() {
+		if (UNEXPECTED(isShared())) {
+			detach();
+		}
+		return m_storage->data;
 	}
 
-	std::map<std::string, Value*>& getData() { return m_data; }
+	const std::map<std::string, Value*>& getData() const { return m_storage->data; }
+
+	bool isShared() const { return m_storage->refCount() > 1; }
 private:
-	std::map<std::string, Value*> m_data;
+	void detach();
+
+	MapStorage* m_storage;
 
 	DISALLOW_COPY_AND_ASSIGN(MapObject);
 };
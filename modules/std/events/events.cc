@@ -30,6 +30,8 @@ CLEVER_THREAD_FUNC(_events_handler)
 {
 	EventData* intern = static_cast<EventData*>(arg);
 
+	Isolate::setCurrent(intern->m_isolate);
+
 	while (true) {
 		intern->mutex.lock();
 
@@ -142,6 +144,7 @@ CLEVER_METHOD(Events::ctor)
 		intern->m_sleep_time = static_cast<int>(args[0]->getInt());
 	}
 
+	intern->m_isolate = Isolate::getCurrent();
 	intern->handler.create(_events_handler, intern);
 
 	intern->m_vm = new VM(*clever->vm);
@@ -165,7 +168,7 @@ CLEVER_METHOD(Events::connect)
 		intern->m_event_map[*v->getStr()]
 			.push_back(static_cast<Function*>(args.at(1)->getObj()));
 	} else if (v->isMap()) {
-		ValueMap& map = static_cast<MapObject*>(v->getObj())->getData();
+		const ValueMap& map = static_cast<const MapObject*>(v->getObj())->getData();
 		RequisitionActionPair action;
 		Requisitions& req = action.first;
 		ValueMap::const_iterator it(map.begin()), end(map.end());
@@ -252,8 +255,8 @@ CLEVER_METHOD(Events::set)
 
 	Value* v = args.at(0);
 
-	ValueMap& map = static_cast<MapObject*>(v->getObj())->getData();
-	ValueMap::iterator it = map.begin(), end = map.end();
+	const ValueMap& map = static_cast<const MapObject*>(v->getObj())->getData();
+	ValueMap::const_iterator it = map.begin(), end = map.end();
 
 	intern->mutex.lock();
 
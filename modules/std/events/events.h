@@ -53,6 +53,8 @@ struct EventData : public TypeObject {
 
 	VM* m_vm;
 
+	Isolate* m_isolate;
+
 	int m_sleep_time;
 
 	EventData() {}
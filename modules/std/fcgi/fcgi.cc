@@ -12,6 +12,9 @@
 
 namespace clever { namespace modules { namespace std {
 
+// Entry point of the plugin, when built as one
+CLEVER_PLUGIN_MODULE("std.fcgi", FCGIModule)
+
 /// Initializes Standard FCGI module
 CLEVER_MODULE_INIT(FCGIModule)
 {
@@ -428,6 +428,9 @@ CLEVER_TYPE_INIT(FFI::init)
 		new Function("callThisFunction", (MethodPtr)&FFI::callThisFunction, this));
 }
 
+// Entry point of the plugin, when built as one
+CLEVER_PLUGIN_MODULE("std.ffi", FFIModule)
+
 // FFI module initialization
 CLEVER_MODULE_INIT(FFIModule)
 {
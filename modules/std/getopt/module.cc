@@ -20,13 +20,13 @@ static CLEVER_FUNCTION(getopt)
 	}
 
 	MapObject* map = new MapObject;
-	ArrayObject* argv = static_cast<ArrayObject*>(args[0]->getObj());
+	const ArrayObject* argv = static_cast<const ArrayObject*>(args[0]->getObj());
 	const char* spec = args[1]->getStr()->c_str();
 	size_t nargs = argv->getData().size();
 	size_t nspec = args[1]->getStr()->size();
 
 	bool has_long_opts = args.size() == 3;
-	ArrayObject* arr_opts = has_long_opts ? static_cast<ArrayObject*>(args[2]->getObj()) : NULL;
+	const ArrayObject* arr_opts = has_long_opts ? static_cast<const ArrayObject*>(args[2]->getObj()) : NULL;
 	size_t nlongopts = has_long_opts ? arr_opts->getData().size() : 0;
 
 	if (nargs == 0) {
@@ -0,0 +1,267 @@
+/**
+ * Clever programming language
+ * Copyright (c) Clever Team
+ *
+ * This file is distributed under the MIT license. See LICENSE for details.
+ */
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include "core/value.h"
+#include "core/native_types.h"
+#include "core/cexception.h"
+#include "core/metrics.h"
+#include "modules/std/core/array.h"
+#include "modules/std/core/function.h"
+#include "modules/std/metrics/metrics.h"
+
+namespace clever { namespace modules { namespace std {
+
+namespace metrics {
+
+static double get_number(const Value* value)
+{
+	return value->isInt() ? double(value->getInt()) : value->getDouble();
+}
+
+// Registers a metric for the counter(), gauge() and histogram() functions
+static Metric* register_metric(const ::std::vector<Value*>& args, Metric::Kind kind,
+	Clever* clever)
+{
+	const CString* name = args[0]->getStr();
+	Metric* metric = Metrics::get(*name, kind, args.size() > 1 ? *args[1]->getStr() : "");
+
+	if (!metric) {
+		if (!Metrics::isValidName(*name)) {
+			clever_throw("Invalid metric name `%S'", name);
+		} else if (Metrics::isReservedName(*name)) {
+			clever_throw("Metric name `%S' is reserved", name);
+		} else {
+			clever_throw("Metric `%S' is already registered with another type", name);
+		}
+	}
+	return metric;
+}
+
+// Looks up a registered metric of the expected kind
+static Metric* find_metric(const CString* name, Metric::Kind kind, bool allow_gauge,
+	Clever* clever)
+{
+	Metric* metric = Metrics::find(*name);
+
+	if (!metric) {
+		clever_throw("Metric `%S' is not registered", name);
+		return NULL;
+	}
+
+	if (metric->getKind() != kind
+		&& !(allow_gauge && metric->getKind() == Metric::GAUGE)) {
+		clever_throw("Metric `%S' has the wrong type for this operation", name);
+		return NULL;
+	}
+	return metric;
+}
+
+// counter(string name [, string help])
+// Registers a counter, a value that only goes up
+static CLEVER_FUNCTION(counter)
+{
+	if (!clever_static_check_args("s|s")) {
+		return;
+	}
+
+	result->setBool(register_metric(args, Metric::COUNTER, clever) != NULL);
+}
+
+// gauge(string name [, string help])
+// Registers a gauge, a value that can go up and down
+static CLEVER_FUNCTION(gauge)
+{
+	if (!clever_static_check_args("s|s")) {
+		return;
+	}
+
+	result->setBool(register_metric(args, Metric::GAUGE, clever) != NULL);
+}
+
+// histogram(string name [, string help [, array buckets]])
+// Registers a histogram; the buckets are the upper bounds of each bucket, the
+// Prometheus client defaults (5ms to 10s) are used when none are supplied
+static CLEVER_FUNCTION(histogram)
+{
+	if (!clever_static_check_args("s|sa")) {
+		return;
+	}
+
+	::std::vector<double> bounds;
+
+	if (args.size() > 2) {
+		const ArrayObject* arr = static_cast<const ArrayObject*>(args[2]->getObj());
+		const ::std::vector<Value*>& data = arr->getData();
+
+		for (size_t i = 0, j = data.size(); i < j; ++i) {
+			if (!data[i] || (!data[i]->isInt() && !data[i]->isDouble())) {
+				clever_throw("Histogram buckets must be numbers");
+				return;
+			}
+			bounds.push_back(get_number(data[i]));
+		}
+	}
+
+	Metric* metric = register_metric(args, Metric::HISTOGRAM, clever);
+
+	if (metric && !bounds.empty()) {
+		metric->setBuckets(bounds);
+	}
+
+	result->setBool(metric != NULL);
+}
+
+// inc(string name [, number value])
+// Adds to a counter or a gauge, 1 by default
+static CLEVER_FUNCTION(inc)
+{
+	if (!clever_static_check_args("s|n")) {
+		return;
+	}
+
+	double value = args.size() > 1 ? get_number(args[1]) : 1;
+	Metric* metric = find_metric(args[0]->getStr(), Metric::COUNTER, true, clever);
+
+	if (!metric) {
+		return;
+	}
+
+	if (value < 0 && metric->getKind() == Metric::COUNTER) {
+		clever_throw("Counters cannot be decreased");
+		return;
+	}
+
+	Metrics::add(metric, value);
+}
+
+// dec(string name [, number value])
+// Subtracts from a gauge, 1 by default
+static CLEVER_FUNCTION(dec)
+{
+	if (!clever_static_check_args("s|n")) {
+		return;
+	}
+
+	Metric* metric = find_metric(args[0]->getStr(), Metric::GAUGE, false, clever);
+
+	if (metric) {
+		Metrics::add(metric, args.size() > 1 ? -get_number(args[1]) : -1);
+	}
+}
+
+// set(string name, number value)
+// Sets a gauge
+static CLEVER_FUNCTION(set)
+{
+	if (!clever_static_check_args("sn")) {
+		return;
+	}
+
+	Metric* metric = find_metric(args[0]->getStr(), Metric::GAUGE, false, clever);
+
+	if (metric) {
+		Metrics::set(metric, get_number(args[1]));
+	}
+}
+
+// observe(string name, number value)
+// Records an observation in a histogram
+static CLEVER_FUNCTION(observe)
+{
+	if (!clever_static_check_args("sn")) {
+		return;
+	}
+
+	Metric* metric = find_metric(args[0]->getStr(), Metric::HISTOGRAM, false, clever);
+
+	if (metric) {
+		Metrics::observe(metric, get_number(args[1]));
+	}
+}
+
+// time_native(bool enable)
+// Enables the clever_native_call_seconds histogram, which costs two clock
+// reads per internal function call
+static CLEVER_FUNCTION(time_native)
+{
+	if (!clever_static_check_args("b")) {
+		return;
+	}
+
+	Metrics::enableNativeTiming(args[0]->getBool());
+}
+
+// render()
+// Returns the runtime and user metrics in the Prometheus text format
+static CLEVER_FUNCTION(render)
+{
+	if (!clever_static_check_no_args()) {
+		return;
+	}
+
+	::std::ostringstream out;
+
+	Metrics::render(out);
+
+	result->setStr(new StrObject(out.str()));
+}
+
+// write(string file)
+// Writes the metrics to a temporary file renamed over `file`, so that
+// readers such as the node_exporter textfile collector never see it
+// partially written
+static CLEVER_FUNCTION(write)
+{
+	if (!clever_static_check_args("s")) {
+		return;
+	}
+
+	const ::std::string& path = *args[0]->getStr();
+	const ::std::string tmp = path + ".tmp";
+	::std::ofstream out(tmp.c_str());
+
+	if (!out) {
+		clever_throw("Couldn't open the file %s", tmp.c_str());
+		return;
+	}
+
+	Metrics::render(out);
+	out.close();
+
+	if (!out || ::std::rename(tmp.c_str(), path.c_str()) != 0) {
+		::std::remove(tmp.c_str());
+		clever_throw("Couldn't write the file %S", args[0]->getStr());
+		return;
+	}
+
+	result->setBool(true);
+}
+
+} // clever::modules::std::metrics
+
+// Load module data
+CLEVER_MODULE_INIT(MetricsModule)
+{
+	// The exported runtime families are counted from now on
+	MemStats::enable();
+
+	addFunction(new Function("counter",     &CLEVER_NS_FNAME(metrics, counter)));
+	addFunction(new Function("gauge",       &CLEVER_NS_FNAME(metrics, gauge)));
+	addFunction(new Function("histogram",   &CLEVER_NS_FNAME(metrics, histogram)));
+	addFunction(new Function("inc",         &CLEVER_NS_FNAME(metrics, inc)));
+	addFunction(new Function("dec",         &CLEVER_NS_FNAME(metrics, dec)));
+	addFunction(new Function("set",         &CLEVER_NS_FNAME(metrics, set)));
+	addFunction(new Function("observe",     &CLEVER_NS_FNAME(metrics, observe)));
+	addFunction(new Function("time_native", &CLEVER_NS_FNAME(metrics, time_native)));
+	addFunction(new Function("render",      &CLEVER_NS_FNAME(metrics, render)));
+	addFunction(new Function("write",       &CLEVER_NS_FNAME(metrics, write)));
+}
+
+}}} // clever::modules::std
@@ -0,0 +1,30 @@
+/**
+ * Clever programming language
+ * Copyright (c) Clever Team
+ *
+ * This file is distributed under the MIT license. See LICENSE for details.
+ */
+
+#ifndef CLEVER_STD_METRICS_H
+#define CLEVER_STD_METRICS_H
+
+#include "core/module.h"
+
+namespace clever { namespace modules { namespace std {
+
+/// Standard Metrics module
+class MetricsModule : public Module {
+public:
+	MetricsModule()
+		: Module("std.metrics") {}
+
+	~MetricsModule() {}
+
+	CLEVER_MODULE_VIRTUAL_METHODS_DECLARATION;
+private:
+	DISALLOW_COPY_AND_ASSIGN(MetricsModule);
+};
+
+}}} // clever::modules::std
+
+#endif // CLEVER_STD_METRICS_H
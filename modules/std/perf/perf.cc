@@ -0,0 +1,297 @@
+/**
+ * Clever programming language
+ * Copyright (c) Clever Team
+ *
+ * This file is distributed under the MIT license. See LICENSE for details.
+ */
+
+#include <cerrno>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <vector>
+#ifdef HAVE_LINUX_PERF_EVENT_H
+# include <linux/perf_event.h>
+# include <sys/ioctl.h>
+# include <sys/syscall.h>
+# include <unistd.h>
+#endif
+#include "core/value.h"
+#include "core/native_types.h"
+#include "core/cexception.h"
+#include "modules/std/core/array.h"
+#include "modules/std/core/map.h"
+#include "modules/std/core/function.h"
+#include "modules/std/perf/perf.h"
+
+namespace clever { namespace modules { namespace std {
+
+namespace perf {
+
+struct EventInfo {
+	const char* name;
+	unsigned type;
+	unsigned long long config;
+};
+
+#ifdef HAVE_LINUX_PERF_EVENT_H
+static const EventInfo g_events[] = {
+	{ "cycles",           PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES          },
+	{ "instructions",     PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS        },
+	{ "cache_references", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_REFERENCES    },
+	{ "cache_misses",     PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES        },
+	{ "branches",         PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_INSTRUCTIONS },
+	{ "branch_misses",    PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES       },
+	{ "task_clock",       PERF_TYPE_SOFTWARE, PERF_COUNT_SW_TASK_CLOCK          },
+	{ "page_faults",      PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS         },
+	{ "context_switches", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES    }
+};
+#else
+static const EventInfo g_events[] = {
+	{ "cycles", 0, 0 }, { "instructions", 0, 0 }, { "cache_references", 0, 0 },
+	{ "cache_misses", 0, 0 }, { "branches", 0, 0 }, { "branch_misses", 0, 0 },
+	{ "task_clock", 0, 0 }, { "page_faults", 0, 0 }, { "context_switches", 0, 0 }
+};
+#endif
+
+static const size_t NUM_EVENTS = sizeof(g_events) / sizeof(g_events[0]);
+
+// Counted when start() is called without a list of events
+static const char* g_default_events[] = {
+	"cycles", "instructions", "cache_misses", "branch_misses"
+};
+
+struct Counter {
+	Counter(const char* name_, int fd_)
+		: name(name_), fd(fd_) {}
+
+	const char* name;
+	int fd;
+};
+
+/// Counters of the calling thread; perf events opened with pid 0 only count
+/// the thread which opened them
+struct CounterSet {
+	::std::vector<Counter> counters;
+	::std::string error;
+};
+
+static THREAD_TLS CounterSet* t_set = NULL;
+
+static CounterSet* get_set()
+{
+	if (!t_set) {
+		t_set = new CounterSet;
+	}
+	return t_set;
+}
+
+static const EventInfo* find_event(const ::std::string& name)
+{
+	for (size_t i = 0; i < NUM_EVENTS; ++i) {
+		if (name == g_events[i].name) {
+			return &g_events[i];
+		}
+	}
+	return NULL;
+}
+
+static void close_counters(CounterSet* set)
+{
+#ifdef HAVE_LINUX_PERF_EVENT_H
+	for (size_t i = 0, j = set->counters.size(); i < j; ++i) {
+		close(set->counters[i].fd);
+	}
+#endif
+	set->counters.clear();
+}
+
+// Opens a counter for the calling thread, user space only so that it works
+// with the default perf_event_paranoid setting; -1 and errno on failure
+static int open_counter(const EventInfo* event)
+{
+#ifdef HAVE_LINUX_PERF_EVENT_H
+	struct perf_event_attr attr;
+
+	memset(&attr, 0, sizeof(attr));
+
+	attr.size           = sizeof(attr);
+	attr.type           = event->type;
+	attr.config         = event->config;
+	attr.disabled       = 1;
+	attr.exclude_kernel = 1;
+	attr.exclude_hv     = 1;
+	attr.read_format    = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+	return syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+#else
+	errno = ENOSYS;
+	return -1;
+#endif
+}
+
+// Explains why the counters could not be opened
+static ::std::string open_error(int err)
+{
+	::std::ostringstream msg;
+
+	msg << strerror(err);
+
+	if (err == EACCES || err == EPERM) {
+		msg << " (see /proc/sys/kernel/perf_event_paranoid)";
+	} else if (err == ENOENT || err == EOPNOTSUPP) {
+		msg << " (the CPU or the hypervisor does not expose this counter)";
+	} else if (err == ENOSYS) {
+		msg << " (perf events are not supported on this system)";
+	}
+	return msg.str();
+}
+
+// Reads a counter, scaling it up when the kernel had to multiplex it
+static long read_counter(const Counter& counter)
+{
+#ifdef HAVE_LINUX_PERF_EVENT_H
+	unsigned long long data[3]; // value, time enabled, time running
+
+	if (::read(counter.fd, data, sizeof(data)) != sizeof(data) || data[2] == 0) {
+		return 0;
+	}
+
+	if (data[2] < data[1]) {
+		return long(double(data[0]) * data[1] / data[2]);
+	}
+	return long(data[0]);
+#else
+	return 0;
+#endif
+}
+
+static void read_counters(const CounterSet* set, Value* result)
+{
+	MapObject* map = new MapObject;
+
+	for (size_t i = 0, j = set->counters.size(); i < j; ++i) {
+		map->insertValue(set->counters[i].name,
+			new Value(read_counter(set->counters[i])));
+	}
+
+	result->setObj(CLEVER_MAP_TYPE, map);
+}
+
+// start([array events])
+// Starts counting the events, by default cycles, instructions, cache_misses
+// and branch_misses, for the calling thread. The events which cannot be
+// counted are left out and error() tells why; returns false if none can be
+static CLEVER_FUNCTION(start)
+{
+	if (!clever_static_check_args("|a")) {
+		return;
+	}
+
+	::std::vector< ::std::string> names;
+
+	if (args.size()) {
+		const ArrayObject* arr = static_cast<const ArrayObject*>(args[0]->getObj());
+		const ::std::vector<Value*>& data = arr->getData();
+
+		for (size_t i = 0, j = data.size(); i < j; ++i) {
+			if (!data[i] || !data[i]->isStr() || !find_event(*data[i]->getStr())) {
+				clever_throw("Unknown event, expected one of cycles, instructions, "
+					"cache_references, cache_misses, branches, branch_misses, "
+					"task_clock, page_faults and context_switches");
+				return;
+			}
+			names.push_back(*data[i]->getStr());
+		}
+	} else {
+		names.assign(g_default_events,
+			g_default_events + sizeof(g_default_events) / sizeof(g_default_events[0]));
+	}
+
+	CounterSet* set = get_set();
+
+	close_counters(set);
+	set->error.clear();
+
+	for (size_t i = 0, j = names.size(); i < j; ++i) {
+		const EventInfo* event = find_event(names[i]);
+		int fd = open_counter(event);
+
+		if (fd < 0) {
+			if (set->error.empty()) {
+				set->error = names[i] + ": " + open_error(errno);
+			}
+			continue;
+		}
+		set->counters.push_back(Counter(event->name, fd));
+	}
+
+#ifdef HAVE_LINUX_PERF_EVENT_H
+	// Enabled together once all of them are open, to count the same region
+	for (size_t i = 0, j = set->counters.size(); i < j; ++i) {
+		ioctl(set->counters[i].fd, PERF_EVENT_IOC_RESET, 0);
+	}
+	for (size_t i = 0, j = set->counters.size(); i < j; ++i) {
+		ioctl(set->counters[i].fd, PERF_EVENT_IOC_ENABLE, 0);
+	}
+#endif
+
+	result->setBool(!set->counters.empty());
+}
+
+// read()
+// Returns a map with the events counted so far, without stopping
+static CLEVER_FUNCTION(read)
+{
+	if (!clever_static_check_no_args()) {
+		return;
+	}
+
+	read_counters(get_set(), result);
+}
+
+// stop()
+// Stops counting and returns a map with the counted events, empty when
+// nothing could be counted
+static CLEVER_FUNCTION(stop)
+{
+	if (!clever_static_check_no_args()) {
+		return;
+	}
+
+	CounterSet* set = get_set();
+
+#ifdef HAVE_LINUX_PERF_EVENT_H
+	for (size_t i = 0, j = set->counters.size(); i < j; ++i) {
+		ioctl(set->counters[i].fd, PERF_EVENT_IOC_DISABLE, 0);
+	}
+#endif
+
+	read_counters(set, result);
+	close_counters(set);
+}
+
+// error()
+// Returns why the last start() could not count some of the events, an
+// empty string when it counts all of them
+static CLEVER_FUNCTION(error)
+{
+	if (!clever_static_check_no_args()) {
+		return;
+	}
+
+	result->setStr(new StrObject(get_set()->error));
+}
+
+} // clever::modules::std::perf
+
+// Load module data
+CLEVER_MODULE_INIT(PerfModule)
+{
+	addFunction(new Function("start", &CLEVER_NS_FNAME(perf, start)));
+	addFunction(new Function("read",  &CLEVER_NS_FNAME(perf, read)));
+	addFunction(new Function("stop",  &CLEVER_NS_FNAME(perf, stop)));
+	addFunction(new Function("error", &CLEVER_NS_FNAME(perf, error)));
+}
+
+}}} // clever::modules::std
@@ -0,0 +1,30 @@
+/**
+ * Clever programming language
+ * Copyright (c) Clever Team
+ *
+ * This file is distributed under the MIT license. See LICENSE for details.
+ */
+
+#ifndef CLEVER_STD_PERF_H
+#define CLEVER_STD_PERF_H
+
+#include "core/module.h"
+
+namespace clever { namespace modules { namespace std {
+
+/// Standard Perf module (hardware performance counters)
+class PerfModule : public Module {
+public:
+	PerfModule()
+		: Module("std.perf") {}
+
+	~PerfModule() {}
+
+	CLEVER_MODULE_VIRTUAL_METHODS_DECLARATION;
+private:
+	DISALLOW_COPY_AND_ASSIGN(PerfModule);
+};
+
+}}} // clever::modules::std
+
+#endif // CLEVER_STD_PERF_H
@@ -5,8 +5,11 @@
  * This file is distributed under the MIT license. See LICENSE for details.
  */
 
+#include <cstring>
 #include <iostream>
 #include "core/driver.h"
+#include "core/isolate.h"
+#include "core/vm.h"
 #include "core/modmanager.h"
 #include "modules/std/reflection/reflection.h"
 #include "modules/std/reflection/reflect.h"
@@ -40,20 +43,35 @@ static CLEVER_FUNCTION(refcount)
 }
 
 // eval(string)
-// Executes the supplied string
+// Executes the supplied string in an isolate of its own
 static CLEVER_FUNCTION(eval)
 {
 	if (!clever_static_check_args("s")) {
 		return;
 	}
 
-	Interpreter interp(0, NULL);
+	const ::std::string code = *args[0]->getStr();
+	const VM* vm = VM::getCurrent();
+	jmp_buf saved;
 
-	if (!interp.loadStr(*args[0]->getStr(), false)) {
-		interp.execute(false);
-		// @TODO(Felipe): must fix cstring freeing
-		// interp.shutdown();
+	memcpy(saved, fatal_error, sizeof(jmp_buf));
+
+	{
+		Isolate isolate;
+		IsolateScope scope(&isolate);
+		Interpreter interp(g_clever_argc, g_clever_argv);
+
+		if (setjmp(fatal_error) == 0) {
+			if (!interp.loadStr(code, false)) {
+				interp.execute(false);
+			}
+		}
+		interp.shutdown();
 	}
+
+	// The fatal errors of the evaluated code must not end the caller
+	memcpy(fatal_error, saved, sizeof(jmp_buf));
+	VM::setCurrent(const_cast<VM*>(vm));
 }
 
 // Bool isnull(Object)
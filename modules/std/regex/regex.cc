@@ -11,6 +11,9 @@
 
 namespace clever { namespace modules { namespace std {
 
+// Entry point of the plugin, when built as one
+CLEVER_PLUGIN_MODULE("std.regex", Regex)
+
 // Regex module initialization
 CLEVER_MODULE_INIT(Regex)
 {
@@ -30,6 +30,15 @@
 #ifdef HAVE_MOD_STD_MATH
 # include "modules/std/math/math.h"
 #endif
+#ifdef HAVE_MOD_STD_BENCH
+# include "modules/std/bench/bench.h"
+#endif
+#ifdef HAVE_MOD_STD_METRICS
+# include "modules/std/metrics/metrics.h"
+#endif
+#ifdef HAVE_MOD_STD_PERF
+# include "modules/std/perf/perf.h"
+#endif
 #ifdef HAVE_MOD_STD_UNICODE
 # include "modules/std/unicode/unicode.h"
 #endif
@@ -9,63 +9,81 @@
 
 namespace clever { namespace modules {
 
-// Initializes Std package
+// Registers the modules of the Std package, created when imported
+// (the ones built as plugins are loaded then)
 void Std::init()
 {
-	addModule(new std::CoreModule);
+	addModule("std.core",         module_factory<std::CoreModule>);
 #ifdef HAVE_MOD_STD_CLEVER
-	addModule(new std::CleverModule);
+	addModule("std.clever",       module_factory<std::CleverModule>);
 #endif
 #ifdef HAVE_MOD_STD_CONCURRENT
-	addModule(new std::ConcurrencyModule);
+	addModule("std.concurrent",   module_factory<std::ConcurrencyModule>);
 #endif
 #ifdef HAVE_MOD_STD_EVENTS
-	addModule(new std::EventsModule);
+	addModule("std.events",       module_factory<std::EventsModule>);
 #endif
 #ifdef HAVE_MOD_STD_DATE
-	addModule(new std::DateModule);
+	addModule("std.date",         module_factory<std::DateModule>);
 #endif
 #ifdef HAVE_MOD_STD_IO
-	addModule(new std::IOModule);
+	addModule("std.io",           module_factory<std::IOModule>);
 #endif
 #ifdef HAVE_MOD_STD_REFLECTION
-	addModule(new std::Reflection);
+	addModule("std.reflection",   module_factory<std::Reflection>);
 #endif
 #ifdef HAVE_MOD_STD_MATH
-	addModule(new std::Math);
+	addModule("std.math",         module_factory<std::Math>);
+#endif
+#ifdef HAVE_MOD_STD_BENCH
+	addModule("std.bench",        module_factory<std::BenchModule>);
+#endif
+#ifdef HAVE_MOD_STD_METRICS
+	addModule("std.metrics",      module_factory<std::MetricsModule>);
+#endif
+#ifdef HAVE_MOD_STD_PERF
+	addModule("std.perf",         module_factory<std::PerfModule>);
 #endif
 #ifdef HAVE_MOD_STD_UNICODE
-	addModule(new std::UnicodeModule);
+	addModule("std.unicode",      module_factory<std::UnicodeModule>);
+#elif defined(HAVE_PLUGIN_STD_UNICODE)
+	addPlugin("std.unicode");
 #endif
 #ifdef HAVE_MOD_STD_FCGI
-	addModule(new std::FCGIModule);
+	addModule("std.fcgi",         module_factory<std::FCGIModule>);
+#elif defined(HAVE_PLUGIN_STD_FCGI)
+	addPlugin("std.fcgi");
 #endif
 #ifdef HAVE_MOD_STD_SYS
-	addModule(new std::SYSModule);
+	addModule("std.sys",          module_factory<std::SYSModule>);
 #endif
 #ifdef HAVE_MOD_STD_FILE
-	addModule(new std::FileModule);
+	addModule("std.file",         module_factory<std::FileModule>);
 #endif
 #ifdef HAVE_MOD_STD_NET
-	addModule(new std::NetModule);
+	addModule("std.net",          module_factory<std::NetModule>);
 #endif
 #ifdef HAVE_MOD_STD_CRYPTO
-	addModule(new std::CryptoModule);
+	addModule("std.crypto",       module_factory<std::CryptoModule>);
 #endif
 #ifdef HAVE_MOD_STD_FFI
-	addModule(new std::FFIModule);
+	addModule("std.ffi",          module_factory<std::FFIModule>);
+#elif defined(HAVE_PLUGIN_STD_FFI)
+	addPlugin("std.ffi");
 #endif
 #ifdef HAVE_MOD_STD_JSON
-	addModule(new std::JsonModule);
+	addModule("std.json",         module_factory<std::JsonModule>);
 #endif
 #ifdef HAVE_MOD_STD_REGEX
-	addModule(new std::Regex);
+	addModule("std.regex",        module_factory<std::Regex>);
+#elif defined(HAVE_PLUGIN_STD_REGEX)
+	addPlugin("std.regex");
 #endif
 #ifdef HAVE_MOD_STD_COLLECTION
-	addModule(new std::CollectionModule);
+	addModule("std.collection",   module_factory<std::CollectionModule>);
 #endif
 #ifdef HAVE_MOD_STD_GETOPT
-	addModule(new std::GetoptModule);
+	addModule("std.getopt",       module_factory<std::GetoptModule>);
 #endif
 }
 
@@ -6,6 +6,7 @@
  */
 
 #include <cstdlib>
+#include <fstream>
 #include <sstream>
 
 #ifdef CLEVER_WIN32
@@ -25,6 +26,12 @@
 #include "core/native_types.h"
 #include "core/modmanager.h"
 #include "core/cexception.h"
+#include "core/memstats.h"
+#include "core/heapsnapshot.h"
+#include "core/profiler.h"
+#include "core/tracer.h"
+#include "core/lockstats.h"
+#include "modules/std/core/map.h"
 #include "modules/std/sys/sys.h"
 
 #ifndef PATH_MAX
@@ -247,6 +254,251 @@ static CLEVER_FUNCTION(info)
 	return result->setStr(new StrObject(oss.str()));
 }
 
+// Returns a Map value with the counters and, when size is non-zero, the bytes
+static Value* memstats_entry(const MemCounter& counter, size_t size)
+{
+	MapObject* map = new MapObject;
+	Value* entry = new Value();
+
+	map->insertValue("allocs", new Value(long(counter.allocs)));
+	map->insertValue("live",   new Value(long(counter.live)));
+	map->insertValue("peak",   new Value(long(counter.peak)));
+
+	if (size) {
+		map->insertValue("bytes",      new Value(long(counter.live * size)));
+		map->insertValue("peak_bytes", new Value(long(counter.peak * size)));
+	}
+
+	entry->setObj(CLEVER_MAP_TYPE, map);
+
+	return entry;
+}
+
+// rusage()
+// Returns a map with the resource usage of the process: the peak resident set
+// size in KB (maxrss), the user and system CPU time in seconds (utime, stime)
+// and the page faults and context switches
+static CLEVER_FUNCTION(rusage)
+{
+	if (!clever_static_check_no_args()) {
+		return;
+	}
+
+#ifndef CLEVER_WIN32
+	struct rusage usage;
+
+	if (getrusage(RUSAGE_SELF, &usage) != 0) {
+		result->setBool(false);
+		return;
+	}
+
+	MapObject* map = new MapObject;
+
+#ifdef __APPLE__
+	// Reported in bytes instead of kilobytes
+	usage.ru_maxrss /= 1024;
+#endif
+
+	map->insertValue("maxrss", new Value(long(usage.ru_maxrss)));
+	map->insertValue("utime",  new Value(usage.ru_utime.tv_sec + usage.ru_utime.tv_usec / 1e6));
+	map->insertValue("stime",  new Value(usage.ru_stime.tv_sec + usage.ru_stime.tv_usec / 1e6));
+	map->insertValue("minflt", new Value(long(usage.ru_minflt)));
+	map->insertValue("majflt", new Value(long(usage.ru_majflt)));
+	map->insertValue("nvcsw",  new Value(long(usage.ru_nvcsw)));
+	map->insertValue("nivcsw", new Value(long(usage.ru_nivcsw)));
+
+	result->setObj(CLEVER_MAP_TYPE, map);
+#else
+	result->setBool(false);
+#endif
+}
+
+// cpu_count()
+// Returns the number of online processors
+static CLEVER_FUNCTION(cpu_count)
+{
+	if (!clever_static_check_no_args()) {
+		return;
+	}
+
+#ifndef CLEVER_WIN32
+	long n = sysconf(_SC_NPROCESSORS_ONLN);
+#else
+	SYSTEM_INFO info;
+
+	GetSystemInfo(&info);
+
+	long n = info.dwNumberOfProcessors;
+#endif
+
+	result->setInt(n > 0 ? n : 1);
+}
+
+// memstats()
+// Returns a map with the allocation counters of the runtime classes and a
+// "types" map with the counters of each type. The first call starts the
+// counting, unless it was enabled at startup.
+static CLEVER_FUNCTION(memstats)
+{
+	if (!clever_static_check_no_args()) {
+		return;
+	}
+
+	MemStats::enable();
+
+	MapObject* map = new MapObject;
+	MapObject* types = new MapObject;
+	Value* types_val = new Value();
+	::std::vector<MemStats::Entry> entries;
+
+	for (size_t i = 0; i < MemStats::NUM_KINDS; ++i) {
+		MemStats::Kind kind = static_cast<MemStats::Kind>(i);
+
+		map->insertValue(MemStats::getName(kind),
+			memstats_entry(MemStats::get(kind), MemStats::getSize(kind)));
+	}
+
+	MemStats::getTypes(entries);
+
+	for (size_t i = 0, j = entries.size(); i < j; ++i) {
+		types->insertValue(entries[i].first, memstats_entry(entries[i].second, 0));
+	}
+
+	types_val->setObj(CLEVER_MAP_TYPE, types);
+	map->insertValue("types", types_val);
+
+	result->setObj(CLEVER_MAP_TYPE, map);
+}
+
+// heap_snapshot(string file)
+// Writes the graph of live values to a .heapsnapshot file
+static CLEVER_FUNCTION(heap_snapshot)
+{
+	if (!clever_static_check_args("s")) {
+		return;
+	}
+
+	HeapSnapshot snapshot(clever->vm);
+
+	result->setBool(snapshot.write(*args[0]->getStr()));
+}
+
+// profile_start([int hz])
+// Starts the sampling profiler, 100 samples per second of CPU time by default;
+// returns false if it is already running (e.g. started by --profile)
+static CLEVER_FUNCTION(profile_start)
+{
+	if (!clever_static_check_args("|i")) {
+		return;
+	}
+
+	long hz = args.size() ? args[0]->getInt() : 100;
+
+	if (Profiler::isRunning()) {
+		result->setBool(false);
+		return;
+	}
+
+	Profiler::reset();
+
+	result->setBool(hz > 0 && Profiler::start(hz));
+}
+
+// profile_stop([string file])
+// Stops the profiler, writes the collapsed stacks to the file if one was
+// supplied and returns the self/total report
+static CLEVER_FUNCTION(profile_stop)
+{
+	if (!clever_static_check_args("|s")) {
+		return;
+	}
+
+	Profiler::stop();
+
+	if (args.size()) {
+		::std::ofstream out(args[0]->getStr()->c_str());
+
+		if (!out) {
+			clever_throw("Couldn't open the file %S", args[0]->getStr());
+			return;
+		}
+		Profiler::writeStacks(out);
+	}
+
+	::std::ostringstream report;
+
+	Profiler::writeReport(report);
+
+	result->setStr(new StrObject(report.str()));
+}
+
+// trace_start()
+// Starts recording every call made by the script
+static CLEVER_FUNCTION(trace_start)
+{
+	if (!clever_static_check_no_args()) {
+		return;
+	}
+
+	Tracer::start();
+}
+
+// trace_stop([string file])
+// Stops the tracer and returns the call graph in the callgrind format,
+// writing it to the file too if one was supplied
+static CLEVER_FUNCTION(trace_stop)
+{
+	if (!clever_static_check_args("|s")) {
+		return;
+	}
+
+	Tracer::stop();
+
+	::std::ostringstream graph;
+
+	Tracer::write(graph, "clever");
+
+	if (args.size()) {
+		::std::ofstream out(args[0]->getStr()->c_str());
+
+		if (!out) {
+			clever_throw("Couldn't open the file %S", args[0]->getStr());
+			return;
+		}
+		out << graph.str();
+	}
+
+	result->setStr(new StrObject(graph.str()));
+}
+
+// lock_stats_start()
+// Starts recording the acquisitions, wait and hold times of the VM lock
+// (critical blocks and function calls) and of the std.concurrent locks
+static CLEVER_FUNCTION(lock_stats_start)
+{
+	if (!clever_static_check_no_args()) {
+		return;
+	}
+
+	LockStats::start();
+}
+
+// lock_stats_stop()
+// Stops recording and returns the report, per lock and per location
+static CLEVER_FUNCTION(lock_stats_stop)
+{
+	if (!clever_static_check_no_args()) {
+		return;
+	}
+
+	::std::ostringstream report;
+
+	LockStats::stop();
+	LockStats::dump(report);
+
+	result->setStr(new StrObject(report.str()));
+}
+
 // Returns a Value ptr containing the OS name
 static Value* get_os()
 {
@@ -299,6 +551,16 @@ CLEVER_MODULE_INIT(SYSModule)
 	addFunction(new Function("time",      &CLEVER_NS_FNAME(sys, time)));
 	addFunction(new Function("microtime", &CLEVER_NS_FNAME(sys, microtime)));
 	addFunction(new Function("info",      &CLEVER_NS_FNAME(sys, info)));
+	addFunction(new Function("memstats",  &CLEVER_NS_FNAME(sys, memstats)));
+	addFunction(new Function("rusage",    &CLEVER_NS_FNAME(sys, rusage)));
+	addFunction(new Function("cpu_count", &CLEVER_NS_FNAME(sys, cpu_count)));
+	addFunction(new Function("heap_snapshot", &CLEVER_NS_FNAME(sys, heap_snapshot)));
+	addFunction(new Function("profile_start", &CLEVER_NS_FNAME(sys, profile_start)));
+	addFunction(new Function("profile_stop",  &CLEVER_NS_FNAME(sys, profile_stop)));
+	addFunction(new Function("trace_start",   &CLEVER_NS_FNAME(sys, trace_start)));
+	addFunction(new Function("trace_stop",    &CLEVER_NS_FNAME(sys, trace_stop)));
+	addFunction(new Function("lock_stats_start", &CLEVER_NS_FNAME(sys, lock_stats_start)));
+	addFunction(new Function("lock_stats_stop",  &CLEVER_NS_FNAME(sys, lock_stats_stop)));
 	addFunction(new Function("exit",      &CLEVER_NS_FNAME(sys, exit)));
 
 	addVariable("OS",   sys::get_os());
@@ -14,6 +14,9 @@
 
 namespace clever { namespace modules { namespace std {
 
+// Entry point of the plugin, when built as one
+CLEVER_PLUGIN_MODULE("std.unicode", UnicodeModule)
+
 /// Initializes Standard Unicode module
 CLEVER_MODULE_INIT(UnicodeModule)
 {
@@ -0,0 +1,421 @@
+/**
+ * Clever programming language
+ * Copyright (c) Clever Team
+ *
+ * This file is distributed under the MIT license. See LICENSE for details.
+ */
+
+/**
+ * Tests of the embedding API (Program and Context), which the script tests
+ * cannot reach. Prints the failed checks and exits with 1 if there is any.
+ */
+
+#include <algorithm>
+#include <iostream>
+#include "core/program.h"
+#include "core/memstats.h"
+#include "core/cstring.h"
+#include "core/cthread.h"
+#include "core/value.h"
+
+using namespace clever;
+
+static size_t g_checks = 0;
+static size_t g_failures = 0;
+
+#define CHECK(cond) \
+	do { \
+		++g_checks; \
+		if (!(cond)) { \
+			std::cerr << __FILE__ << ":" << __LINE__ << ": " #cond << std::endl; \
+			++g_failures; \
+		} \
+	} while (0)
+
+static const char* g_script =
+	"class Req {\n"
+	"	var n;\n"
+	"\n"
+	"	function Req(n) {\n"
+	"		this.n = n;\n"
+	"	}\n"
+	"\n"
+	"	function get() {\n"
+	"		return this.n;\n"
+	"	}\n"
+	"}\n"
+	"\n"
+	"var last;\n"
+	"\n"
+	"// Objects and closures unreachable once the call returns\n"
+	"function handle(n) {\n"
+	"	var req = Req.new(n);\n"
+	"	var f = function() { return req.get(); };\n"
+	"	return f();\n"
+	"}\n"
+	"\n"
+	"// An object kept by a global, replacing the previous one\n"
+	"function keep(n) {\n"
+	"	last = Req.new(Req.new(n));\n"
+	"	return last.get().get();\n"
+	"}\n"
+	"\n"
+	"function last_n() {\n"
+	"	return last.get().get();\n"
+	"}\n";
+
+static const char* g_state_script =
+	"var count = 0;\n"
+	"var name = 'main';\n"
+	"\n"
+	"function inc() {\n"
+	"	return ++count;\n"
+	"}\n"
+	"\n"
+	"// An uncaught exception\n"
+	"function fail() {\n"
+	"	throw 'call failed';\n"
+	"}\n";
+
+static const char* g_failing_script =
+	"var count = 1;\n"
+	"\n"
+	"throw 'run failed';\n"
+	"\n"
+	"function one() {\n"
+	"	return 1;\n"
+	"}\n";
+
+/// Script of an isolate, whose globals and strings are named after its tag
+static std::string isolate_script(const std::string& tag)
+{
+	return "var " + tag + "_calls = 0;\n"
+		"var words = [];\n"
+		"\n"
+		"function work(n) {\n"
+		"	++" + tag + "_calls;\n"
+		"	words.append('" + tag + "');\n"
+		"	var map = {'" + tag + "': n};\n"
+		"	return map['" + tag + "'];\n"
+		"}\n"
+		"\n"
+		"function word() {\n"
+		"	return words[0] + '-' + words.size().toString();\n"
+		"}\n";
+}
+
+/// Calls the function `times' times, checking its result
+static void call(Context& ctx, const char* name, long times)
+{
+	for (long i = 0; i < times; ++i) {
+		ValueVector args;
+
+		args.push_back(new Value(i));
+
+		Value* result = ctx.call(name, args);
+
+		CHECK(result != NULL && result->isInt() && result->getInt() == i);
+
+		clever_delref(result);
+		std::for_each(args.begin(), args.end(), clever_delref);
+	}
+}
+
+static bool same_live_counts(const size_t* before)
+{
+	for (size_t i = 0; i < MemStats::NUM_KINDS; ++i) {
+		if (MemStats::get(static_cast<MemStats::Kind>(i)).live != before[i]) {
+			return false;
+		}
+	}
+	return true;
+}
+
+static void save_live_counts(size_t* counts)
+{
+	for (size_t i = 0; i < MemStats::NUM_KINDS; ++i) {
+		counts[i] = MemStats::get(static_cast<MemStats::Kind>(i)).live;
+	}
+}
+
+// Repeated calls of a reused context must not leak the objects they create
+static void test_call_releases_objects(const Program& program)
+{
+	IsolateScope scope(program.getIsolate());
+	Context ctx(&program);
+	size_t live[MemStats::NUM_KINDS];
+
+	CHECK(ctx.run());
+
+	call(ctx, "handle", 100);
+	save_live_counts(live);
+	call(ctx, "handle", 1000);
+	CHECK(same_live_counts(live));
+
+	call(ctx, "keep", 100);
+	save_live_counts(live);
+	call(ctx, "keep", 1000);
+	CHECK(same_live_counts(live));
+
+	// The object referenced by the global survived the calls
+	Value* result = ctx.call("last_n");
+
+	CHECK(result != NULL && result->isInt() && result->getInt() == 999);
+	clever_delref(result);
+}
+
+/// Checks that the global is an int with this value
+static bool int_global(const Context& ctx, const char* name, long n)
+{
+	const Value* value = ctx.getGlobal(name);
+
+	return value != NULL && value->isInt() && value->getInt() == n;
+}
+
+/// Checks that the function returns an int with this value
+static bool call_int(Context& ctx, const char* name, long n)
+{
+	Value* result = ctx.call(name);
+	bool ok = result != NULL && result->isInt() && result->getInt() == n;
+
+	clever_delref(result);
+	return ok;
+}
+
+// Globals are kept between calls and can be read and set by the embedder
+static void test_globals(const Program& program)
+{
+	IsolateScope scope(program.getIsolate());
+	Context ctx(&program);
+
+	CHECK(ctx.run());
+	CHECK(int_global(ctx, "count", 0));
+	CHECK(call_int(ctx, "inc", 1));
+	CHECK(call_int(ctx, "inc", 2));
+	CHECK(int_global(ctx, "count", 2));
+
+	const Value* name = ctx.getGlobal("name");
+
+	CHECK(name != NULL && name->isStr() && *name->getStr() == "main");
+
+	Value value(41L);
+
+	CHECK(ctx.setGlobal("count", &value));
+	CHECK(call_int(ctx, "inc", 42));
+
+	CHECK(ctx.getGlobal("missing") == NULL);
+	CHECK(!ctx.setGlobal("missing", &value));
+	CHECK(ctx.call("missing") == NULL);
+}
+
+// reset() gives fresh globals, which run() initializes again
+static void test_reset(const Program& program)
+{
+	IsolateScope scope(program.getIsolate());
+	Context ctx(&program);
+
+	CHECK(ctx.run());
+	CHECK(call_int(ctx, "inc", 1));
+
+	ctx.reset();
+	CHECK(ctx.run());
+	CHECK(int_global(ctx, "count", 0));
+	CHECK(call_int(ctx, "inc", 1));
+}
+
+// A fatal error fails run() or call() and leaves a usable context, with
+// fresh globals which the main code must set again
+static void test_fatal_errors(const Program& program)
+{
+	IsolateScope scope(program.getIsolate());
+	Context ctx(&program);
+
+	CHECK(ctx.run());
+	CHECK(call_int(ctx, "inc", 1));
+
+	CHECK(ctx.call("fail") == NULL);
+	CHECK(!int_global(ctx, "count", 0));
+
+	// The globals are not initialized until the main code runs again
+	CHECK(ctx.call("inc") == NULL);
+
+	CHECK(ctx.run());
+	CHECK(call_int(ctx, "inc", 1));
+	CHECK(call_int(ctx, "inc", 2));
+}
+
+// A main code which fails can be run again, the context staying usable
+static void test_fatal_error_in_run(const Program& program)
+{
+	IsolateScope scope(program.getIsolate());
+	Context ctx(&program);
+
+	CHECK(!ctx.run());
+	CHECK(!ctx.run());
+	CHECK(!int_global(ctx, "count", 1));
+	CHECK(call_int(ctx, "one", 1));
+}
+
+/// A program run on a thread of its own, and what it saw there
+struct IsolateRun {
+	IsolateRun(const std::string& tag_, const std::string& other_)
+		: tag(tag_), other(other_), compiled(false), results(false),
+			own_globals(false), own_types(false), own_strings(false),
+			int_type(NULL), str_type(NULL), interned(NULL) {}
+
+	std::string tag;
+	std::string other;
+	Program program;
+
+	bool compiled;
+	bool results;
+	bool own_globals;
+	bool own_types;
+	bool own_strings;
+
+	const Type* int_type;
+	const Type* str_type;
+	const CString* interned;
+};
+
+static CLEVER_THREAD_FUNC(run_isolate)
+{
+	IsolateRun* run = static_cast<IsolateRun*>(arg);
+
+	if (!run->program.loadStr(isolate_script(run->tag))) {
+		return NULL;
+	}
+	run->compiled = true;
+
+	IsolateScope scope(run->program.getIsolate());
+	Context ctx(&run->program);
+
+	run->results = ctx.run();
+
+	for (long i = 0; i < 1000; ++i) {
+		ValueVector args;
+
+		args.push_back(new Value(i));
+
+		Value* result = ctx.call("work", args);
+
+		if (result == NULL || result->getType() != CLEVER_INT_TYPE
+			|| result->getInt() != i) {
+			run->results = false;
+		}
+
+		clever_delref(result);
+		std::for_each(args.begin(), args.end(), clever_delref);
+	}
+
+	Value* word = ctx.call("word");
+
+	run->own_types = word != NULL && word->getType() == CLEVER_STR_TYPE
+		&& CLEVER_STR_TYPE == run->program.getIsolate()->getTypes().str_type;
+	run->results = run->results && word != NULL && word->isStr()
+		&& *word->getStr() == run->tag + "-1000";
+
+	clever_delref(word);
+
+	run->own_globals = int_global(ctx, (run->tag + "_calls").c_str(), 1000)
+		&& ctx.getGlobal(run->other + "_calls") == NULL;
+
+	run->interned = CSTRING("interned");
+	run->own_strings = CSTRING("interned") == run->interned
+		&& CSTRING(run->tag) == CSTRING(run->tag);
+
+	run->int_type = CLEVER_INT_TYPE;
+	run->str_type = CLEVER_STR_TYPE;
+
+	return NULL;
+}
+
+// Programs run in parallel, each in its own isolate, share no globals,
+// types or interned strings
+static void test_parallel_isolates()
+{
+	IsolateRun a("a", "b"), b("b", "a");
+	CThread ta, tb;
+
+	ta.create(run_isolate, &a);
+	tb.create(run_isolate, &b);
+	ta.wait();
+	tb.wait();
+
+	CHECK(a.compiled && b.compiled);
+	CHECK(a.results && b.results);
+	CHECK(a.own_globals && b.own_globals);
+	CHECK(a.own_types && b.own_types);
+	CHECK(a.own_strings && b.own_strings);
+
+	CHECK(a.int_type != NULL && a.int_type != b.int_type);
+	CHECK(a.str_type != NULL && a.str_type != b.str_type);
+	CHECK(a.interned != NULL && a.interned != b.interned);
+
+	a.program.shutdown();
+	b.program.shutdown();
+}
+
+// Scripts which do not compile are reported as such
+static void test_bad_source()
+{
+	Program syntax_error, undeclared;
+
+	// Rejected by the parser and by the code generation respectively
+	CHECK(!syntax_error.loadStr("var = ;"));
+	CHECK(!syntax_error.isCompiled());
+
+	CHECK(!undeclared.loadStr("undeclared_var = 1;"));
+	CHECK(!undeclared.isCompiled());
+
+	syntax_error.shutdown();
+	undeclared.shutdown();
+}
+
+int main()
+{
+	Program program;
+
+	MemStats::enable();
+
+	if (!program.loadStr(g_script)) {
+		std::cerr << "Failed to compile the test script" << std::endl;
+		return 1;
+	}
+
+	test_call_releases_objects(program);
+
+	program.shutdown();
+
+	Program state;
+
+	if (!state.loadStr(g_state_script)) {
+		std::cerr << "Failed to compile the test script" << std::endl;
+		return 1;
+	}
+
+	test_globals(state);
+	test_reset(state);
+	test_fatal_errors(state);
+
+	state.shutdown();
+
+	Program failing;
+
+	if (!failing.loadStr(g_failing_script)) {
+		std::cerr << "Failed to compile the test script" << std::endl;
+		return 1;
+	}
+
+	test_fatal_error_in_run(failing);
+
+	failing.shutdown();
+
+	test_bad_source();
+
+	test_parallel_isolates();
+
+	std::cout << g_checks << " checks, " << g_failures << " failed" << std::endl;
+
+	return g_failures ? 1 : 0;
+}